@@ -0,0 +1,134 @@
+#include "allocation_tracker.h"
+#include <cerrno>          // For posix_memalign error codes
+#include <cstdlib>         // For malloc and free
+#include <new>             // For std::bad_alloc
+
+#ifdef HERD_TRACK_ALLOCATIONS
+
+// Allocation count for each thread, so other threads don't affect a tick
+static thread_local quint64 allocationCount = 0;
+
+#ifdef __GLIBC__
+// glibc's own allocator entry points
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+
+// Replacing malloc also counts Qt containers and strings
+extern "C" void* malloc(size_t size)
+{
+    ++allocationCount;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    ++allocationCount;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size)
+{
+    ++allocationCount;
+    return __libc_realloc(pointer, size);
+}
+
+// Aligned allocations, also used by aligned operator new
+extern "C" int posix_memalign(void** pointer, size_t alignment, size_t size)
+{
+    // Alignment must be a power of two and a multiple of the pointer size
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    ++allocationCount;
+    void* result = __libc_memalign(alignment, size);
+    if (!result)
+    {
+        return ENOMEM;
+    }
+    *pointer = result;
+    return 0;
+}
+
+extern "C" void* aligned_alloc(size_t alignment, size_t size)
+{
+    ++allocationCount;
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* memalign(size_t alignment, size_t size)
+{
+    ++allocationCount;
+    return __libc_memalign(alignment, size);
+}
+
+// operator new goes straight to glibc so it isn't counted twice
+static void* rawAllocate(std::size_t size)
+{
+    ++allocationCount;
+    return __libc_malloc(size);
+}
+#else
+static void* rawAllocate(std::size_t size)
+{
+    ++allocationCount;
+    return std::malloc(size);
+}
+#endif
+
+// Global operator new replacements
+void* operator new(std::size_t size)
+{
+    if (void* pointer = rawAllocate(size ? size : 1))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return rawAllocate(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return rawAllocate(size ? size : 1);
+}
+
+// Matching operator delete replacements
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+bool AllocationTracker::isEnabled()
+{
+    return true;
+}
+
+quint64 AllocationTracker::threadAllocations()
+{
+    return allocationCount;
+}
+
+#else
+
+bool AllocationTracker::isEnabled()
+{
+    return false;
+}
+
+quint64 AllocationTracker::threadAllocations()
+{
+    return 0;
+}
+
+#endif // HERD_TRACK_ALLOCATIONS
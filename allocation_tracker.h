@@ -0,0 +1,20 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <QtGlobal>         // Qt types
+
+// Allocation tracker class counting heap allocations per thread
+// Counting only happens in builds with HERD_TRACK_ALLOCATIONS defined, where
+// operator new (and on glibc malloc, calloc, realloc and the aligned
+// allocators, which Qt containers use) are replaced
+class AllocationTracker
+{
+public:
+    // True when the build counts allocations
+    static bool isEnabled();
+
+    // Number of allocations made by the calling thread so far, 0 if disabled
+    static quint64 threadAllocations();
+};
+
+#endif // ALLOCATION_TRACKER_H
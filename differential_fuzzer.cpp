@@ -0,0 +1,196 @@
+#include "differential_fuzzer.h"
+#include "game_simulation.h"
+#include "reference_game.h"
+#include "scenario.h"
+#include <QRandomGenerator> // For the fuzzing choices
+#include <QStringList>      // For the operation log
+#include <QTextStream>      // For printing results
+#include <cstring>          // For memcmp
+
+
+// Compares two doubles bit for bit
+static bool sameBits(double a, double b)
+{
+    return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// Runs every case
+int DifferentialFuzzer::run(quint32 seed, int cases, int days, QTextStream& out)
+{
+    for (int i = 0; i < cases; ++i)
+    {
+        quint32 caseSeed = seed + static_cast<quint32>(i);
+        if (!runCase(caseSeed, days, out))
+        {
+            out << "Replay with: --fuzz " << caseSeed << " --fuzz-cases 1 --days " << days << "\n";
+            return 1;
+        }
+    }
+    out << cases << " cases of " << days << " days matched\n";
+    return 0;
+}
+
+// Runs one random game on both games
+bool DifferentialFuzzer::runCase(quint32 caseSeed, int days, QTextStream& out)
+{
+    QRandomGenerator driver(caseSeed);
+    QStringList log;  // What was done, printed if the games differ
+
+    // Random starting scenario
+    Scenario scenario;
+    scenario.fieldSize = driver.bounded(GameSimulation::fieldSizes.size());
+    int gridWidth = GameSimulation::width / GameSimulation::fieldSizes[scenario.fieldSize];
+    int gridHeight = GameSimulation::height / GameSimulation::fieldSizes[scenario.fieldSize];
+    scenario.seed = driver.generate();
+    scenario.money = driver.bounded(2) == 0 ? 0 : driver.bounded(100000);
+    scenario.growthAmount = driver.bounded(1 + gridWidth * gridHeight / 4);
+    scenario.herdWidth = 1 + driver.bounded(gridWidth);
+    scenario.herdHeight = 1 + driver.bounded(gridHeight);
+    // The reference game visits every herd cell on every move, so big herds move less
+    scenario.herdSpeed = 1 + driver.bounded(qMax(1, 100000 / (scenario.herdWidth * scenario.herdHeight)));
+    if (driver.bounded(4) == 0)
+    {
+        scenario.growthMode = "spreading";
+        scenario.spreadSettings.neighbours = driver.bounded(2) == 0 ? 4 : 8;
+        scenario.spreadSettings.seedRate = driver.bounded(17);
+        scenario.spreadSettings.spreadRate = driver.bounded(17);
+        scenario.spreadSettings.threads = 1 + driver.bounded(4);
+    }
+    log.append(QString("field %1, seed %2, money %3, growth %4 %5, herd %6x%7 speed %8")
+                   .arg(scenario.fieldSize).arg(scenario.seed).arg(scenario.money)
+                   .arg(scenario.growthMode.isEmpty() ? QString("random") : scenario.growthMode)
+                   .arg(scenario.growthAmount).arg(scenario.herdWidth).arg(scenario.herdHeight)
+                   .arg(scenario.herdSpeed));
+
+    // Both games start the clock at the same time, so lag turns into the same super days
+    GameSimulation fast;
+    ReferenceGame reference;
+    qint64 clock = 1000000;
+    fast.trackTime(clock);
+    reference.trackTime(clock);
+
+    // The reference ignores the thread count, it always grows one cell at a time
+    QString errorMessage;
+    if (!fast.applyScenario(scenario, &errorMessage) || !reference.applyScenario(scenario, &errorMessage))
+    {
+        out << "Case " << caseSeed << ": " << errorMessage << "\n";
+        return false;
+    }
+
+    QString mismatch = difference(fast, reference);
+    for (int day = 1; day <= days && mismatch.isEmpty(); ++day)
+    {
+        // Sometimes a day arrives late, which gives super days
+        clock += fast.getDayRate();
+        if (driver.bounded(4) == 0)
+        {
+            clock += driver.bounded(fast.getDayRate() * 40 + 1);
+        }
+        fast.trackTime(clock);
+        reference.trackTime(clock);
+
+        // Sometimes buy an upgrade
+        if (driver.bounded(3) == 0)
+        {
+            const QVector<GameSimulation::Upgrade*>& upgrades = fast.getUpgrades();
+            QString name = upgrades[driver.bounded(upgrades.size())]->name;
+            bool bought = fast.buyUpgrade(name);
+            if (bought != reference.buyUpgrade(name))
+            {
+                mismatch = QString("buying %1 went differently").arg(name);
+                break;
+            }
+            if (bought)
+            {
+                log.append(QString("day %1: bought %2").arg(day).arg(name));
+            }
+        }
+
+        // Rarely switch the growth mode
+        if (driver.bounded(50) == 0)
+        {
+            GameSimulation::GrowthMode mode = fast.getGrowthMode() == GameSimulation::GrowthMode::Random
+                                                  ? GameSimulation::GrowthMode::Spreading
+                                                  : GameSimulation::GrowthMode::Random;
+            fast.setGrowthMode(mode);
+            reference.setSpreading(mode == GameSimulation::GrowthMode::Spreading);
+            log.append(QString("day %1: growth mode %2").arg(day)
+                           .arg(mode == GameSimulation::GrowthMode::Spreading ? "spreading" : "random"));
+        }
+
+        // The reference always does whole days, the game sometimes does them in slices
+        reference.herdDay();
+        reference.growthDay();
+        if (driver.bounded(2) == 0)
+        {
+            fast.herdDay();
+            fast.growthDay();
+        }
+        else
+        {
+            fast.beginDay();
+            while (!fast.stepHerd(1 + driver.bounded(fast.getHerdSpeed())))
+            {
+            }
+            while (!fast.stepGrowth(1 + driver.bounded(fast.getGrowthAmount() + 1)))
+            {
+            }
+        }
+
+        mismatch = difference(fast, reference);
+        if (!mismatch.isEmpty())
+        {
+            mismatch = QString("day %1: %2").arg(day).arg(mismatch);
+        }
+    }
+
+    if (mismatch.isEmpty())
+    {
+        return true;
+    }
+
+    // Show what led up to the difference
+    out << "Case " << caseSeed << " differs, " << mismatch << "\n";
+    int first = qMax(1, log.size() - 10);
+    out << "  " << log[0] << "\n";
+    for (int i = first; i < log.size(); ++i)
+    {
+        out << "  " << log[i] << "\n";
+    }
+    return false;
+}
+
+// Compares everything that affects later days
+QString DifferentialFuzzer::difference(const GameSimulation& fast, const ReferenceGame& reference)
+{
+    if (!sameBits(fast.getMoney(), reference.getMoney()))
+        return QString("money %1 vs %2").arg(fast.getMoney(), 0, 'f', 2).arg(reference.getMoney(), 0, 'f', 2);
+    if (!sameBits(fast.getTotalMoney(), reference.getTotalMoney()))
+        return QString("total money %1 vs %2").arg(fast.getTotalMoney(), 0, 'f', 2).arg(reference.getTotalMoney(), 0, 'f', 2);
+    if (!sameBits(fast.getTotalCleared(), reference.getTotalCleared()))
+        return QString("total cleared %1 vs %2").arg(fast.getTotalCleared(), 0, 'f', 0).arg(reference.getTotalCleared(), 0, 'f', 0);
+    if (fast.getSuperDays() != reference.getSuperDays())
+        return QString("super days %1 vs %2").arg(fast.getSuperDays()).arg(reference.getSuperDays());
+    if (fast.getHerdX() != reference.getHerdX() || fast.getHerdY() != reference.getHerdY()
+        || fast.isHerdMovingUp() != reference.isHerdMovingUp())
+        return QString("herd at (%1, %2) vs (%3, %4)").arg(fast.getHerdX()).arg(fast.getHerdY())
+                   .arg(reference.getHerdX()).arg(reference.getHerdY());
+    if (fast.getHerdWidth() != reference.getHerdWidth() || fast.getHerdHeight() != reference.getHerdHeight()
+        || fast.getHerdSpeed() != reference.getHerdSpeed() || fast.getGrowthAmount() != reference.getGrowthAmount()
+        || fast.getFieldSize() != reference.getFieldSize() || fast.getDayRate() != reference.getDayRate())
+        return "upgrade values differ";
+
+    // The reference keeps its field row by row, so cells are compared one at a time
+    const PastureGrid& grid = fast.getGrid();
+    if (grid.width() != reference.gridWidth() || grid.height() != reference.gridHeight())
+        return "field sizes differ";
+    for (int y = 0; y < grid.height(); ++y)
+    {
+        for (int x = 0; x < grid.width(); ++x)
+        {
+            if (grid.at(x, y) != reference.at(x, y))
+                return QString("cell (%1, %2) is %3 vs %4").arg(x).arg(y).arg(grid.at(x, y)).arg(reference.at(x, y));
+        }
+    }
+    return QString();
+}
@@ -0,0 +1,32 @@
+#ifndef DIFFERENTIAL_FUZZER_H
+#define DIFFERENTIAL_FUZZER_H
+
+#include <QtGlobal>         // Qt types
+#include <QString>          // Difference descriptions
+
+class QTextStream;
+class GameSimulation;
+class ReferenceGame;
+
+// Differential fuzzer checking the game against the plain reference game
+// Each case starts a GameSimulation and a ReferenceGame from the same random
+// scenario and drives both with the same random lag, upgrade purchases and
+// growth mode changes. The two share no field storage or day code, so after
+// every day the whole game state has to be bit-identical, including the money
+// and every cell of the field
+class DifferentialFuzzer
+{
+public:
+    // Runs cases with seeds seed, seed + 1, ... and returns the process exit code
+    // A failing case prints its seed, so it can be replayed on its own
+    static int run(quint32 seed, int cases, int days, QTextStream& out);
+
+private:
+    // Runs one case, returns false at the first day the games differ
+    static bool runCase(quint32 caseSeed, int days, QTextStream& out);
+
+    // Describes the first difference between two games, empty if they match
+    static QString difference(const GameSimulation& fast, const ReferenceGame& reference);
+};
+
+#endif // DIFFERENTIAL_FUZZER_H
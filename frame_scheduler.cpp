@@ -0,0 +1,94 @@
+#include "frame_scheduler.h"
+#include "allocation_tracker.h"
+
+
+// Scheduler constructor
+FrameScheduler::FrameScheduler(int frameInterval, int budget, QObject* parent)
+    : QObject(parent), frameInterval(frameInterval), budget(budget)
+{
+    connect(&frameTimer, &QTimer::timeout, this, &FrameScheduler::runFrame);
+}
+
+// Sets the task for a priority
+void FrameScheduler::setTask(Priority priority, Task task)
+{
+    tasks[priority] = task;
+}
+
+// Marks a task as having work
+void FrameScheduler::wake(Priority priority)
+{
+    pending[priority] = true;
+
+    // An idle scheduler runs the first frame right away, so a click is
+    // answered as soon as Qt gets back to its event loop
+    if (!frameTimer.isActive())
+    {
+        frameTimer.start(0);
+    }
+}
+
+// Runs one frame of work
+void FrameScheduler::runFrame()
+{
+    frameClock.start();
+    quint64 allocationsBefore = AllocationTracker::threadAllocations();
+    frameTimer.setInterval(frameInterval);
+    bool ran[PriorityCount] = {};
+
+    // Tasks that waited too long go first, highest priority first
+    for (int priority = 0; priority < PriorityCount; ++priority)
+    {
+        if (pending[priority] && waitedFrames[priority] >= maxWaitFrames)
+        {
+            runTask(priority);
+            ran[priority] = true;
+        }
+    }
+
+    // Then always the highest priority task with work, until the budget is used up
+    // A task can wake a higher priority one, so the search starts over after each slice
+    while (hasTimeLeft())
+    {
+        int next = 0;
+        while (next < PriorityCount && !pending[next])
+        {
+            next++;
+        }
+        if (next == PriorityCount)
+        {
+            break;
+        }
+        runTask(next);
+        ran[next] = true;
+    }
+
+    // Remember which tasks had to wait
+    bool anyPending = false;
+    for (int priority = 0; priority < PriorityCount; ++priority)
+    {
+        waitedFrames[priority] = pending[priority] && !ran[priority] ? waitedFrames[priority] + 1 : 0;
+        anyPending = anyPending || pending[priority];
+    }
+
+    lastFrameNanoseconds = frameClock.nsecsElapsed();
+    lastFrameAllocations = AllocationTracker::threadAllocations() - allocationsBefore;
+    framesRun++;
+
+    // Nothing left to do until something wakes a task again
+    if (!anyPending)
+    {
+        frameTimer.stop();
+    }
+}
+
+// Runs one slice of a task
+void FrameScheduler::runTask(int priority)
+{
+    // Cleared first, so a task can wake itself again
+    pending[priority] = false;
+    if (tasks[priority] && tasks[priority]())
+    {
+        pending[priority] = true;
+    }
+}
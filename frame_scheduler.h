@@ -0,0 +1,74 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <QObject>          // Base class for signals and slots
+#include <QTimer>           // Frame timer
+#include <QElapsedTimer>    // Frame budget
+#include <functional>       // For std::function
+
+// Frame scheduler class running game work in slices with a time budget per frame
+// Each frame the pending task with the highest priority runs first, and the
+// frame ends when the budget is used up so Qt can handle input and painting.
+// Tasks keep their own progress and carry on in the next frame.
+class FrameScheduler : public QObject
+{
+    // Qt macro to include signals and slots
+    Q_OBJECT
+
+public:
+    // Task priorities, highest first
+    enum Priority {
+        Input,          // Responses to clicks
+        Herd,           // Herd moves of the current day
+        Growth,         // Grass growth of the current day
+        Stats,          // Labels and buttons
+        Paint,          // Field display
+        PriorityCount
+    };
+
+    // A task does one slice of work and returns true while it has more to do
+    // Long tasks should check hasTimeLeft() and return early when it is false
+    using Task = std::function<bool()>;
+
+    // constructor, frameInterval and budget are in milliseconds
+    explicit FrameScheduler(int frameInterval = 16, int budget = 8, QObject* parent = nullptr);
+
+    // Sets the task for a priority
+    void setTask(Priority priority, Task task);
+
+    // Marks a task as having work, frames run until no task has work left
+    void wake(Priority priority);
+
+    // true while the current frame still has budget, tasks check this between slices
+    bool hasTimeLeft() const { return frameClock.nsecsElapsed() < budget * 1000000LL; }
+
+    // methods to get scheduler statistics
+    qint64 getLastFrameNanoseconds() const { return lastFrameNanoseconds; }
+    quint64 getLastFrameAllocations() const { return lastFrameAllocations; }  // 0 unless allocations are tracked
+    quint64 getFramesRun() const { return framesRun; }
+
+private slots:
+    void runFrame();    // Runs tasks until the budget is used up
+
+private:
+    // A task that waited this many frames runs first, so painting can't be starved by a long backlog
+    static const int maxWaitFrames = 4;
+
+    Task tasks[PriorityCount];           // Task for each priority
+    bool pending[PriorityCount] = {};    // true if the task has work
+    int waitedFrames[PriorityCount] = {};// Frames a pending task did not get to run
+
+    QTimer frameTimer;          // Runs a frame every frameInterval while there is work
+    QElapsedTimer frameClock;   // Time since the frame started
+    int frameInterval;          // Milliseconds between frames
+    int budget;                 // Milliseconds of work per frame
+
+    // Statistics
+    qint64 lastFrameNanoseconds = 0;  // Time spent in the last frame
+    quint64 lastFrameAllocations = 0; // Heap allocations made by every task in the last frame
+    quint64 framesRun = 0;            // Frames that ran work
+
+    void runTask(int priority);  // Runs one slice of a task
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,611 @@
+#include "game_simulation.h"
+#include "scenario.h"
+#include <QDateTime>       // For time calculations
+#include <cmath>           // For math functions
+
+
+// Field sizes vector declaration
+// Larger numbers are more zoomed out
+const QVector<int> GameSimulation::fieldSizes = {50, 25, 20, 10, 5, 4, 2, 1};
+
+// Upgrade implementation
+// Constructor to initialize all upgrade variables
+GameSimulation::Upgrade::Upgrade(const QString& name, double price, double multiplier,
+                                 std::function<void()> onBuy, const QString& displayText,
+                                 const QString& displayName, std::function<bool()> canBuy)
+    : name(name), displayName(displayName), displayText(displayText),
+    price(price), multiplier(multiplier), onBuy(onBuy), canBuy(canBuy), level(0)
+{}
+
+
+// Applies upgrade purchase effects and increases price
+void GameSimulation::Upgrade::buy()
+{
+    // Check if upgrade can be purchased
+    if (canBuy())
+    {
+        onBuy();                // Execute the upgrade effect
+        level++;                // Increase upgrade level
+        price *= multiplier;    // Increase price for next purchase
+    }
+}
+
+// Gets display text for UI
+QString GameSimulation::Upgrade::getDisplayText() const
+{
+    return displayText;
+}
+
+
+// Simulation constructor
+GameSimulation::GameSimulation()
+    // Initialize all game state variables
+    : money(0), totalMoney(0),                            // Start with no money
+    herdX(0), herdY(0),                                 // Herd starts at top left
+    herdWidth(1), herdHeight(1),                        // Herd starts as 1 cow by 1 cow
+    herdSpeed(1),                                       // 1 acre per day
+    herdDirectionUp(false),                             // Start moving down
+    growthAmount(4),                                    // 4 growth actions per day
+    fieldSize(0),                                       // Start with largest field size
+    dayRate(1000),                                      // 1 second per game day
+    totalCleared(0),                                    // No grass cleared yet
+    lastDay(0), superExtra(0), superDays(0),            // Time tracking
+    random(1)                                           // Same field every new game
+{
+    grid.reserve(width, height);                   // Room for the finest field size
+    spreading.reserve(width, height);              // Same for spreading growth
+    generateField();                               // Creates initial field
+    lastDay = QDateTime::currentMSecsSinceEpoch(); // QDateTime function to return current miliseconds
+    initializeUpgrades();                          // Create all available upgrades
+}
+
+// Destructor to delete allocated memory
+GameSimulation::~GameSimulation()
+{
+    // Delete upgrades to prevent memory leak
+    qDeleteAll(upgrades);
+}
+
+// Initialize upgrades function
+void GameSimulation::initializeUpgrades()
+{
+    // Herd speed upgrade
+    // Increases how many moves the herd makes per day
+    upgrades.append(new Upgrade(
+        "herdSpeed",           // Internal name
+        speedBasePrice,        // Starting price: $50
+        speedMultiplier,       // Price multiplier: 2.0 (doubles each purchase)
+        [this](){ this->herdSpeed++; },  // Effect: increase herd speed by 1
+        "acres/day",           // Display text
+        "Herd Speed",          // User friendly name
+        [this](){ return this->herdSpeed < 50; }  // Can buy until speed reaches 50
+        ));
+
+    // herd size upgrade
+    // Increases the area the herd covers when moving
+    upgrades.append(new Upgrade(
+        "herdSize",
+        sizeBasePrice,         // Starting price: $75
+        sizeMultiplier,        // Price multiplier: 1.3 (30% increase)
+        [this]()
+        {
+            // Alternate between increasing width and height
+            if (this->herdWidth == this->herdHeight) {
+                this->herdWidth++;   // Increase width if square
+            }
+            else
+            {
+                this->herdHeight++;  // Increase height if rectangular
+            }
+            // Reset position to top-left when size changes
+            this->herdX = 0;
+            this->herdY = 0;
+        },
+        "size",                // Display text
+        "Herd Size",           // User friendly name
+        [this]()
+        {
+            // Can't exceed field boundaries
+            int maxSize = height / fieldSizes[this->fieldSize];
+            return this->herdHeight < maxSize && this->herdWidth < maxSize;
+        }
+        ));
+
+    // field size upgrade
+    // Changes the zoom level
+    upgrades.append(new Upgrade(
+        "fieldSize",
+        fieldBasePrice,        // Starting price: $150
+        fieldMultiplier,       // Price multiplier: 2.5 (150% increase)
+        [this]() {
+            // Increase field size index (makes cells smaller)
+            this->fieldSize = qMin(this->fieldSize + 1, fieldSizes.size() - 1);
+            this->regenerateField();  // Recreate field with new cell size
+        },
+        "field size",          // Display text
+        "Field Size",          // User friendly name
+        [this]() {
+            // Can buy until reaching smallest field size
+            return this->fieldSize < fieldSizes.size() - 1;
+        }
+        ));
+
+    // growth rate upgrade
+    // Increases how much grass grows per day
+    upgrades.append(new Upgrade(
+        "growthRate",
+        growthBasePrice,       // Starting price: $10
+        growthMultiplier,      // Price multiplier: 1.15 (15% increase)
+        [this]()
+        {
+            this->growthAmount += 2;  // Increase growth by 2 units per day
+        },
+        "growth/day",          // Display text
+        "Growth Rate",         // User friendly name
+        [this]()
+        {
+            // Can buy until growth reaches 100 per day
+            return this->growthAmount < 100;
+        }
+        ));
+
+
+
+    // day rate upgrade
+    // Speeds up the game by reducing time between days
+    upgrades.append(new Upgrade(
+        "dayRate",
+        dayBasePrice,          // Starting price: $5
+        dayMultiplier,         // Price multiplier: 1.15 (15% increase)
+        [this]()
+        {
+            // Reduce day rate by 15%, minimum 1ms
+            this->dayRate = qMax(1, static_cast<int>(this->dayRate * 0.85));
+        },
+        "ms",                  // Display text
+        "Day Rate",            // User friendly name
+        [this]()
+        {
+            // Can buy until day rate reaches 1ms
+            return this->dayRate > 1;
+        }
+        ));
+}
+
+// generate field function to create the field
+void GameSimulation::generateField()
+{
+    // Calculate grid dimensions based on current field size
+    int gridWidth = width / fieldSizes[fieldSize];
+    int gridHeight = height / fieldSizes[fieldSize];
+
+    // Resize the grid to match dimensions, reusing its memory
+    grid.resize(gridWidth, gridHeight);
+    for (int i = 0; i < gridWidth; ++i)
+    {
+        quint8* column = grid.column(i);
+        for (int j = 0; j < gridHeight; ++j)
+        {
+            // Initialize each cell with random growth level
+            column[j] = static_cast<quint8>(random.bounded(maxGrowth));
+        }
+    }
+}
+
+
+// Regenerate field function when field size changes
+void GameSimulation::regenerateField()
+{
+    generateField();    // Overwrite every cell with a new field
+}
+
+// Uses time between days for super days
+void GameSimulation::trackTime(qint64 currentTime)
+{
+    // Gets time since last day
+    qint64 timeDifference = currentTime - lastDay;
+    lastDay = currentTime;
+
+    // Uses extra time for super days
+    superExtra += timeDifference - dayRate;
+    if (superExtra > dayRate * 5)
+    {
+        superDays += static_cast<int>(superExtra / 5 / dayRate);
+        superExtra = fmod(superExtra, dayRate * 5);
+    }
+}
+
+// Clears grown grass in a rectangle of cells and pays for it
+// right and bottom are one past the last cell, anything outside the field is skipped
+void GameSimulation::harvestArea(int left, int top, int right, int bottom)
+{
+    int gridWidth = width / fieldSizes[fieldSize];
+    int gridHeight = height / fieldSizes[fieldSize];
+    right = qMin(right, gridWidth);
+    bottom = qMin(bottom, gridHeight);
+
+    for (int x = left; x < right; ++x)
+    {
+        quint8* column = grid.column(x);  // Cells of a column are next to each other
+        for (int y = top; y < bottom; ++y)
+        {
+            // Check if grass is grown
+            if (column[y] >= 5)
+            {
+                // Clears grass and lets views know the cell changed
+                column[y] = 0;
+                grid.touchCell(x, y);
+                // Gets money
+                double value = 1.0 * (superDays > 0 ? 5 : 1);
+                money += value;
+                totalMoney += value;
+                totalCleared++;
+
+                // Use up a super day if it is active
+                if (superDays > 0)
+                {
+                    superDays--;
+                }
+            }
+        }
+    }
+}
+
+// Number of columns the herd visits in one sweep of the field
+// Columns are herdWidth apart, the last one is moved left to fit the field
+int GameSimulation::sweepColumns() const
+{
+    int lastX = width / fieldSizes[fieldSize] - herdWidth;
+    return (lastX + herdWidth - 1) / herdWidth + 1;
+}
+
+// Number of moves in one full sweep, after which the herd is back at the top left
+// Each column takes one move per row plus one move to the next column
+qint64 GameSimulation::sweepLength() const
+{
+    int rows = height / fieldSizes[fieldSize] - herdHeight + 1;
+    return static_cast<qint64>(sweepColumns()) * rows;
+}
+
+// Finds how many moves into the sweep the herd is
+// Returns false if the herd is off the sweep path, which happens when the
+// field grows while the herd is in the last column
+bool GameSimulation::sweepIndex(qint64* index) const
+{
+    int lastX = width / fieldSizes[fieldSize] - herdWidth;
+    int rows = height / fieldSizes[fieldSize] - herdHeight + 1;
+    if (herdY < 0 || herdY >= rows)
+        return false;
+
+    // Which column of the sweep the herd is in
+    int column;
+    if (herdX == lastX)
+        column = sweepColumns() - 1;
+    else if (herdX % herdWidth == 0)
+        column = herdX / herdWidth;
+    else
+        return false;
+
+    // Odd columns are walked upwards
+    if (herdDirectionUp != (column % 2 == 1))
+        return false;
+
+    int row = herdDirectionUp ? rows - 1 - herdY : herdY;
+    *index = static_cast<qint64>(column) * rows + row;
+    return true;
+}
+
+// Places the herd a number of moves into the sweep
+void GameSimulation::setSweepIndex(qint64 index)
+{
+    int lastX = width / fieldSizes[fieldSize] - herdWidth;
+    int rows = height / fieldSizes[fieldSize] - herdHeight + 1;
+    int column = static_cast<int>(index / rows);
+    int row = static_cast<int>(index % rows);
+
+    herdX = qMin(column * herdWidth, lastX);
+    herdDirectionUp = column % 2 == 1;
+    herdY = herdDirectionUp ? rows - 1 - row : row;
+}
+
+// All herd activity for one day
+void GameSimulation::herdDay()
+{
+    moveHerd(herdSpeed);
+}
+
+// Makes a number of herd moves
+// The herd sweeps down and up the field in columns. Instead of one move at a
+// time, each stretch of moves inside a column is cleared as one rectangle
+// No grass grows between moves, so making the moves in parts gives the same result
+void GameSimulation::moveHerd(qint64 moves)
+{
+    // Gets current grid dimensions
+    int gridWidth = width / fieldSizes[fieldSize];
+    int gridHeight = height / fieldSizes[fieldSize];
+    int lastX = gridWidth - herdWidth;     // Rightmost herd position
+    int lastY = gridHeight - herdHeight;   // Lowest herd position
+
+    while (moves > 0)
+    {
+        // A full sweep clears every cell, so whole sweeps only move the herd
+        qint64 index;
+        if (moves >= sweepLength() && sweepIndex(&index))
+        {
+            harvestArea(0, 0, gridWidth, gridHeight);
+            setSweepIndex((index + moves) % sweepLength());
+            break;
+        }
+
+        // Moves left before the herd reaches the end of this column
+        int steps = herdDirectionUp ? herdY : qMax(0, lastY - herdY);
+
+        if (moves <= steps)
+        {
+            // The day ends inside this column
+            int endY = herdDirectionUp ? herdY - static_cast<int>(moves) : herdY + static_cast<int>(moves);
+            int top = herdDirectionUp ? endY + 1 : herdY;
+            int bottom = herdDirectionUp ? herdY : endY - 1;
+            harvestArea(herdX, top, herdX + herdWidth, bottom + herdHeight);
+            herdY = endY;
+            break;
+        }
+
+        // Clear the rest of the column, including the end position
+        int endY = herdDirectionUp ? 0 : qMax(herdY, lastY);
+        harvestArea(herdX, qMin(herdY, endY), herdX + herdWidth, qMax(herdY, endY) + herdHeight);
+        herdY = endY;
+        moves -= steps + 1;
+
+        // Herd movement at the end of a column
+        if (herdX >= lastX)  // At the right edge
+        {
+            // Reset to start position
+            herdDirectionUp = false;
+            herdX = 0;
+            herdY = 0;
+        }
+        else  // Not at the right edge
+        {
+            // Move right and turn around
+            herdX = qMin(herdX + herdWidth, lastX);
+            herdDirectionUp = !herdDirectionUp;
+        }
+
+        // A mapped field can start reading the column after this one
+        grid.prefetchColumns(herdX + herdWidth, herdWidth);
+    }
+}
+
+// Processes grass growth for one day
+void GameSimulation::growthDay()
+{
+    if (growthMode == GrowthMode::Spreading)
+    {
+        spreadCells();
+    }
+    else
+    {
+        growCells(growthAmount);
+    }
+}
+
+// Grows a number of random cells
+// Cells are picked in the same order however the count is split up
+void GameSimulation::growCells(int count)
+{
+    int gridWidth = width / fieldSizes[fieldSize];
+    int gridHeight = height / fieldSizes[fieldSize];
+
+    // Grow grass multiple times based on growth rate
+    for (int i = 0; i < count; ++i)
+    {
+        // Pick a random cell to grow
+        int x = random.bounded(gridWidth);
+        int y = random.bounded(gridHeight);
+
+        // If grass isn't fully grown, increase its growth level
+        if (grid.at(x, y) < maxGrowth)
+        {
+            grid.set(x, y, qMin(maxGrowth, grid.at(x, y) + 1));
+        }
+    }
+}
+
+// Moves the field into a pasture file
+// A saved field is never written over, the game switches to its field size instead
+bool GameSimulation::usePastureFile(const QString& path, QString* errorMessage)
+{
+    int savedWidth = 0;
+    int savedHeight = 0;
+    if (!PastureFile::readSize(path, &savedWidth, &savedHeight, errorMessage))
+        return false;
+
+    // Find the field size of the saved field
+    int savedFieldSize = fieldSize;
+    if (savedWidth != 0 || savedHeight != 0)
+    {
+        savedFieldSize = -1;
+        for (int i = 0; i < fieldSizes.size(); ++i)
+        {
+            if (width / fieldSizes[i] == savedWidth && height / fieldSizes[i] == savedHeight)
+                savedFieldSize = i;
+        }
+        if (savedFieldSize < 0)
+        {
+            *errorMessage = QString("%1 holds a %2x%3 pasture, which is not a field size of this game")
+                                .arg(path).arg(savedWidth).arg(savedHeight);
+            return false;
+        }
+    }
+
+    bool loaded = false;
+    if (!grid.mapFile(path, width * height, &loaded, errorMessage))
+        return false;
+
+    // The herd starts its sweep over on a loaded field and has to fit on it
+    if (loaded)
+    {
+        fieldSize = savedFieldSize;
+        herdWidth = qMin(herdWidth, grid.width());
+        herdHeight = qMin(herdHeight, grid.height());
+        herdX = 0;
+        herdY = 0;
+        herdDirectionUp = false;
+    }
+    return true;
+}
+
+// Grows every cell from its neighbours
+void GameSimulation::spreadCells()
+{
+    spreading.day(grid);
+}
+
+// Starts a resumable day
+// Herd moves come first, growth starts once the herd is done
+void GameSimulation::beginDay()
+{
+    herdMovesLeft = herdSpeed;
+    dayGrowthMode = growthMode;
+    // Spreading growth is one pass over the field
+    growthsLeft = dayGrowthMode == GrowthMode::Spreading ? 1 : growthAmount;
+}
+
+// Makes part of the day's herd moves
+bool GameSimulation::stepHerd(qint64 maxMoves)
+{
+    qint64 moves = qMin(maxMoves, herdMovesLeft);
+    moveHerd(moves);
+    herdMovesLeft -= moves;
+    return herdMovesLeft == 0;
+}
+
+// Does part of the day's growth, once the herd is done
+bool GameSimulation::stepGrowth(int maxGrowths)
+{
+    if (herdMovesLeft > 0)
+        return false;
+
+    // A spreading day takes well under a frame even on the finest field, so it isn't split
+    if (dayGrowthMode == GrowthMode::Spreading)
+    {
+        if (growthsLeft > 0)
+            spreadCells();
+        growthsLeft = 0;
+        return true;
+    }
+
+    int growths = qMin(maxGrowths, growthsLeft);
+    growCells(growths);
+    growthsLeft -= growths;
+    return growthsLeft == 0;
+}
+
+// Get upgrade by its internal name
+GameSimulation::Upgrade* GameSimulation::getUpgrade(const QString& name)
+{
+    // Searches all upgrades
+    for (Upgrade* upgrade : upgrades)
+    {
+        if (upgrade->name == name)
+        {
+            return upgrade;
+        }
+    }
+    return nullptr; // Returns nothing if upgrade is not found
+}
+
+// Buys the named upgrade
+// Returns true if the purchase went through
+bool GameSimulation::buyUpgrade(const QString& name)
+{
+    if (Upgrade* upgrade = getUpgrade(name))
+    {
+        // Check if player can afford and upgrade is available
+        if (money >= upgrade->price && upgrade->canBuy())
+        {
+            upgrade->buy();          // Apply upgrade effects
+            money -= upgrade->price; // Deduct cost
+            if(money < 0)            // Safety check (shouldn't happen)
+                money = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Restarts the game from a scenario
+// Upgrade levels are bought for free first, then explicit values override them
+bool GameSimulation::applyScenario(const Scenario& scenario, QString* errorMessage)
+{
+    if (scenario.fieldSize < 0 || scenario.fieldSize >= fieldSizes.size())
+    {
+        *errorMessage = QString("fieldSize must be between 0 and %1").arg(fieldSizes.size() - 1);
+        return false;
+    }
+    fieldSize = scenario.fieldSize;
+
+    // Buy upgrade levels, stopping early if an upgrade maxes out
+    for (auto it = scenario.upgradeLevels.constBegin(); it != scenario.upgradeLevels.constEnd(); ++it)
+    {
+        Upgrade* upgrade = getUpgrade(it.key());
+        if (!upgrade)
+        {
+            *errorMessage = QString("Unknown upgrade %1").arg(it.key());
+            return false;
+        }
+        for (int i = 0; i < it.value() && upgrade->canBuy(); ++i)
+        {
+            upgrade->buy();
+        }
+    }
+
+    // Explicit values
+    int gridWidth = width / fieldSizes[fieldSize];
+    int gridHeight = height / fieldSizes[fieldSize];
+    if (scenario.growthAmount >= 0)
+        growthAmount = scenario.growthAmount;
+    if (scenario.dayRate > 0)
+        dayRate = scenario.dayRate;
+    if (scenario.herdWidth > 0)
+        herdWidth = qMin(scenario.herdWidth, gridWidth);
+    if (scenario.herdHeight > 0)
+        herdHeight = qMin(scenario.herdHeight, gridHeight);
+    if (scenario.herdSpeed > 0)
+        herdSpeed = scenario.herdSpeed;
+
+    // Growth mode
+    if (scenario.growthMode == "spreading")
+    {
+        if (!spreading.setSettings(scenario.spreadSettings, errorMessage))
+            return false;
+        growthMode = GrowthMode::Spreading;
+    }
+    else if (scenario.growthMode.isEmpty() || scenario.growthMode == "random")
+    {
+        growthMode = GrowthMode::Random;
+    }
+    else
+    {
+        *errorMessage = QString("Unknown growth mode %1").arg(scenario.growthMode);
+        return false;
+    }
+
+    // Fresh game state
+    money = scenario.money;
+    totalMoney = 0;
+    totalCleared = 0;
+    superExtra = 0;
+    superDays = 0;
+    herdMovesLeft = 0;
+    growthsLeft = 0;
+    herdX = 0;
+    herdY = 0;
+    herdDirectionUp = false;
+
+    // Seed last so the field only depends on the seed and field size
+    random.seed(scenario.seed);
+    regenerateField();
+    return true;
+}
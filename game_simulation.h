@@ -0,0 +1,175 @@
+#ifndef GAME_SIMULATION_H
+#define GAME_SIMULATION_H
+
+#include <QtGlobal>         // Qt types and macros
+#include <QVector>          // Dynamic array container
+#include <QString>          // Text for upgrade names
+#include <QRandomGenerator> // Seeded random numbers for the field and growth
+#include "pasture_grid.h"   // Field cells
+#include "spreading_growth.h" // Growth from neighbours
+#include <functional>       // For std::function
+
+struct Scenario;
+
+// Game simulation class holding the field, the herd and the money
+// It has no UI so the same game can run in the window or headless
+class GameSimulation
+{
+public:
+    // constructor to create a new game
+    GameSimulation();
+
+    // deconstructor to delete new data
+    ~GameSimulation();
+
+    // constant values
+    static const int width = 500;           // Field width in pixels
+    static const int height = 500;          // Field height in pixels
+    static constexpr int maxGrowth = 15;    // Maximum grass growth level
+    static const QVector<int> fieldSizes;   // Available field sizes for zoom levels
+
+    // How grass grows each day
+    enum class GrowthMode {
+        Random,     // growthAmount random cells grow one level
+        Spreading   // Every cell grows from mature neighbours, see SpreadingGrowth
+    };
+
+    // upgrade structure to define upgrades and how they behave
+    struct Upgrade {
+        // upgrade properties
+        QString name;                   // Internal identifier not seen in UI
+        QString displayName;            // Name in UI
+        QString displayText;            // Description text for UI
+        double price;                   // Current cost to purchase
+        double multiplier;              // Price increase multiplier after purchase
+        std::function<void()> onBuy;    // Function called when upgrade is purchased
+        std::function<bool()> canBuy;   // Function that checks if upgrade is available
+        int level;                      // Current upgrade level
+
+        // Constructor that initializes all upgrade properties
+        Upgrade(const QString& name, double price, double multiplier, std::function<void()> onBuy,
+                const QString& displayText, const QString& displayName, std::function<bool()> canBuy);
+
+        // Struct functions
+        void buy();                         // Applies the upgrade effects and increases price
+        QString getDisplayText() const;     // Returns the display text for UI
+    };
+
+    // Game logic functions
+    void trackTime(qint64 currentTime);         // Turns time lost between days into super days
+    void herdDay();                             // Processes herd movement and grass clearing per day
+    void growthDay();                           // Processes grass growth per day
+
+    // Resumable day, so a large day can be spread over several frames
+    // Moves and growth are counted when the day begins, later upgrades apply from the next day
+    void beginDay();                            // Starts a day, the steps below do its work
+    bool stepHerd(qint64 maxMoves);             // Makes up to maxMoves herd moves, true when the herd is done for the day
+    bool stepGrowth(int maxGrowths);            // Grows up to maxGrowths cells, true when growth is done for the day
+    bool isDayRunning() const { return herdMovesLeft > 0 || growthsLeft > 0; }
+    Upgrade* getUpgrade(const QString& name);   // Finds upgrade by name
+    const QVector<Upgrade*>& getUpgrades() const { return upgrades; }  // All upgrades in a fixed order
+    bool buyUpgrade(const QString& name);       // Buys an upgrade if it is available and affordable
+    bool applyScenario(const Scenario& scenario, QString* errorMessage);  // Restarts the game from a scenario
+
+    // Keeps the field in a memory-mapped pasture file from now on
+    // A field saved in the file replaces the field and sets the field size, a new file gets the current field
+    bool usePastureFile(const QString& path, QString* errorMessage);
+
+    // Growth mode, a change applies from the next day
+    void setGrowthMode(GrowthMode mode) { growthMode = mode; }
+    GrowthMode getGrowthMode() const { return growthMode; }
+    bool setSpreadSettings(const SpreadingGrowth::Settings& settings, QString* errorMessage)
+    {
+        return spreading.setSettings(settings, errorMessage);
+    }
+    const SpreadingGrowth::Settings& getSpreadSettings() const { return spreading.getSettings(); }
+
+    // methods to get values for the game state
+    const PastureGrid& getGrid() const { return grid; }
+    double getMoney() const { return money; }
+    double getTotalMoney() const { return totalMoney; }
+    double getTotalCleared() const { return totalCleared; }
+    int getHerdX() const { return herdX; }
+    int getHerdY() const { return herdY; }
+    int getHerdWidth() const { return herdWidth; }
+    int getHerdHeight() const { return herdHeight; }
+    int getHerdSpeed() const { return herdSpeed; }
+    int getGrowthAmount() const { return growthAmount; }
+    int getFieldSize() const { return fieldSize; }
+    int getDayRate() const { return dayRate; }
+    int getSuperDays() const { return superDays; }
+    bool isHerdMovingUp() const { return herdDirectionUp; }
+
+private:
+    // Upgrades capture this object, so it must never be copied
+    Q_DISABLE_COPY(GameSimulation)
+
+    // money variables
+    double money;        // Current available money for purchases
+    double totalMoney;   // Total money earned over game lifetime
+
+    // herd values
+    PastureGrid grid;            // 2D grid representing the field, each cell has grass growth level 0-15
+    int herdX, herdY;            // Current position of the herd, (0,0) is at the top-left corner
+    int herdWidth, herdHeight;   // Size of the herd in grid cells
+    int herdSpeed;               // How many moves the herd makes per day
+    bool herdDirectionUp;        // true = moving up, false = moving down
+
+    // field values
+    int growthAmount;    // How much grass grows per day
+    int fieldSize;       // Current zoom level for fieldSizes vector
+    int dayRate;         // Milliseconds between game days
+    double totalCleared; // Total number of grass tiles cleared over game lifetime
+
+    qint64 lastDay;      // Last time a game day was processed
+    double superExtra;   // Accumulated extra time for super days calculation
+    int superDays;       // Bonus days that give 5 times the money
+
+    // Random numbers for the field and growth, seeded so runs can be repeated
+    QRandomGenerator random;
+
+    // Growth
+    GrowthMode growthMode = GrowthMode::Random;     // Mode for new days
+    GrowthMode dayGrowthMode = GrowthMode::Random;  // Mode of the day started with beginDay()
+    SpreadingGrowth spreading;                      // Spreading mode state
+
+    // Work left in a day started with beginDay()
+    qint64 herdMovesLeft = 0;   // Herd moves not made yet
+    int growthsLeft = 0;        // Growth actions not done yet
+
+    // upgrades
+    QVector<Upgrade*> upgrades;  // List of available upgrades
+
+    // upgrade base prices
+    const double growthBasePrice = 10;   // Cost to increase growth rate
+    const double speedBasePrice = 50;    // Cost to increase herd speed
+    const double sizeBasePrice = 75;     // Cost to increase herd size
+    const double fieldBasePrice = 150;   // Cost to change field size
+    const double dayBasePrice = 5;       // Cost to speed up game days
+
+    // upgrade price multipliers
+    const double growthMultiplier = 1.15;  // 15% price increase
+    const double speedMultiplier = 2.0;    // 100% price increase
+    const double sizeMultiplier = 1.3;     // 30% price increase
+    const double fieldMultiplier = 2.5;    // 150% price increase
+    const double dayMultiplier = 1.15;     // 15% price increase
+
+    // Game initialization functions
+    void initializeUpgrades();  // Creates all available upgrades
+
+    // Field functions
+    void generateField();       // Creates a new field
+    void regenerateField();     // Clears and recreates the field
+
+    // Herd sweep functions
+    void moveHerd(qint64 moves);               // Makes a number of herd moves
+    void growCells(int count);                 // Grows a number of random cells
+    void spreadCells();                        // Grows every cell from its neighbours
+    void harvestArea(int left, int top, int right, int bottom);  // Clears grown grass in a rectangle
+    int sweepColumns() const;                  // Columns in one sweep of the field
+    qint64 sweepLength() const;                // Moves in one sweep of the field
+    bool sweepIndex(qint64* index) const;      // Moves into the sweep the herd is, if it is on the path
+    void setSweepIndex(qint64 index);          // Places the herd a number of moves into the sweep
+};
+
+#endif // GAME_SIMULATION_H
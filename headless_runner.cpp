@@ -0,0 +1,312 @@
+#include "headless_runner.h"
+#include "allocation_tracker.h"
+#include "differential_fuzzer.h"
+#include "game_simulation.h"
+#include "scenario.h"
+#include "telemetry_client.h"
+#include "telemetry_server.h"
+#include "time_lapse_exporter.h"
+#include <QCommandLineParser>  // For parsing options
+#include <QCoreApplication>    // For delivering socket events
+#include <QElapsedTimer>       // For measuring run time
+#include <QScopedPointer>      // For the optional exporter
+#include <QTextStream>         // For printing reports
+#include <cstring>             // For strncmp
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>      // For peak memory use
+#endif
+
+
+// Returns the peak resident set size in kilobytes, or -1 if unknown
+static long peakResidentKilobytes()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef Q_OS_MACOS
+        return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+        return usage.ru_maxrss;         // Kilobytes on Linux
+#endif
+    }
+#endif
+    return -1;
+}
+
+// Looks for options that need headless mode
+bool HeadlessRunner::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        // Matches both "--option value" and "--option=value"
+        if (strncmp(argv[i], "--export", 8) == 0 || strncmp(argv[i], "--scenario", 10) == 0
+            || strncmp(argv[i], "--watch-telemetry", 17) == 0 || strncmp(argv[i], "--fuzz", 6) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parses the options and runs the simulation
+int HeadlessRunner::run(const QStringList& arguments)
+{
+    QTextStream err(stderr);
+
+    // Command line options
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Herd of Grazing Cows headless runs and time-lapse export");
+    parser.addHelpOption();
+    QCommandLineOption scenarioOption("scenario", "Start from the scenario in <file> (.ini or .json).", "file");
+    QCommandLineOption exportOption("export", "Write a time-lapse to <file>, - for stdout.", "file");
+    QCommandLineOption formatOption("format", "Frame format: y4m or ppm (default from file name, else y4m).", "format");
+    QCommandLineOption daysOption("days", "Number of days to simulate (default from the scenario, else 1000).", "days");
+    QCommandLineOption everyOption("every", "Write a frame every <n> days (default 1).", "n", "1");
+    QCommandLineOption fpsOption("fps", "Frame rate written to Y4M streams (default 30).", "fps", "30");
+    QCommandLineOption buffersOption("frame-buffers", "Frames queued for the encoder before the simulation waits (default 8).", "n", "8");
+    QCommandLineOption checkAllocationsOption("check-allocations", "Fail if simulating a day allocates memory.");
+    QCommandLineOption telemetryOption("telemetry", "Stream the game to local socket <name>, waiting up to 10 s for a client.", "name");
+    QCommandLineOption watchOption("watch-telemetry", "Print the stream from local socket <name> and check it.", "name");
+    QCommandLineOption pastureOption("pasture", "Keep the field in memory-mapped <file>, loading the field saved in it.", "file");
+    QCommandLineOption fuzzOption("fuzz", "Check the game against the plain reference game on random games from <seed>.", "seed");
+    QCommandLineOption fuzzCasesOption("fuzz-cases", "Number of random games to compare (default 100).", "n", "100");
+    parser.addOptions({scenarioOption, exportOption, formatOption, daysOption, everyOption, fpsOption, buffersOption,
+                       checkAllocationsOption, telemetryOption, watchOption, pastureOption, fuzzOption, fuzzCasesOption});
+    parser.process(arguments);
+
+    // Reference comparison, fuzzed games are short so they default to 200 days
+    if (parser.isSet(fuzzOption))
+    {
+        // ctest runs this, so a typo has to fail instead of checking nothing
+        bool seedOk = false;
+        bool casesOk = false;
+        bool daysOk = true;
+        quint32 fuzzSeed = parser.value(fuzzOption).toUInt(&seedOk);
+        int fuzzCases = parser.value(fuzzCasesOption).toInt(&casesOk);
+        int fuzzDays = parser.isSet(daysOption) ? parser.value(daysOption).toInt(&daysOk) : 200;
+        if (!seedOk || !casesOk || !daysOk || fuzzCases < 1 || fuzzDays < 1)
+        {
+            err << "Usage: --fuzz <seed> [--fuzz-cases <n>] [--days <n>], n at least 1\n";
+            return 1;
+        }
+
+        QTextStream out(stdout);
+        return DifferentialFuzzer::run(fuzzSeed, fuzzCases, fuzzDays, out);
+    }
+
+    // Stand-in client for another run's telemetry
+    if (parser.isSet(watchOption))
+    {
+        QTextStream out(stdout);
+        TelemetryClient client;
+        return client.run(parser.value(watchOption), out);
+    }
+
+    // Set up the game from the scenario
+    GameSimulation simulation;
+    Scenario scenario;
+    if (parser.isSet(scenarioOption))
+    {
+        QString errorMessage;
+        if (!scenario.load(parser.value(scenarioOption), &errorMessage)
+            || !simulation.applyScenario(scenario, &errorMessage))
+        {
+            err << errorMessage << "\n";
+            return 1;
+        }
+    }
+    if (parser.isSet(pastureOption))
+    {
+        QString errorMessage;
+        if (!simulation.usePastureFile(parser.value(pastureOption), &errorMessage))
+        {
+            err << errorMessage << "\n";
+            return 1;
+        }
+    }
+    // A typo must not turn into a run of 0 days that passes every check
+    bool ok = true;
+    int days = parser.isSet(daysOption) ? parser.value(daysOption).toInt(&ok) : scenario.days;
+    if (!ok || days < 1)
+    {
+        if (parser.isSet(daysOption))
+            err << "Invalid --days: " << parser.value(daysOption) << "\n";
+        else
+            err << "Invalid run/days in the scenario: " << days << "\n";
+        return 1;
+    }
+    int every = parser.value(everyOption).toInt(&ok);
+    if (!ok || every < 1)
+    {
+        err << "Invalid --every: " << parser.value(everyOption) << "\n";
+        return 1;
+    }
+    if (parser.isSet(checkAllocationsOption) && !AllocationTracker::isEnabled())
+    {
+        err << "--check-allocations needs a build with HERD_TRACK_ALLOCATIONS\n";
+        return 1;
+    }
+
+    // Optional time-lapse export
+    QScopedPointer<TimeLapseExporter> exporter;
+    QString path = parser.value(exportOption);
+    if (parser.isSet(exportOption))
+    {
+        // Pick the format from the option or the file extension
+        QString formatName = parser.value(formatOption).toLower();
+        if (formatName.isEmpty())
+        {
+            formatName = path.endsWith(".ppm", Qt::CaseInsensitive) ? "ppm" : "y4m";
+        }
+        if (formatName != "y4m" && formatName != "ppm")
+        {
+            err << "Unknown format: " << formatName << "\n";
+            return 1;
+        }
+        TimeLapseExporter::Format format = formatName == "ppm" ? TimeLapseExporter::Format::PPM
+                                                               : TimeLapseExporter::Format::Y4M;
+
+        // Checked before the output is opened, a bad Y4M header is only noticed after the whole export
+        int fps = parser.value(fpsOption).toInt(&ok);
+        if (!ok || fps < 1)
+        {
+            err << "Invalid --fps: " << parser.value(fpsOption) << "\n";
+            return 1;
+        }
+        int buffers = parser.value(buffersOption).toInt(&ok);
+        if (!ok || buffers < 1)
+        {
+            err << "Invalid --frame-buffers: " << parser.value(buffersOption) << "\n";
+            return 1;
+        }
+
+        // There is no realtime clock to keep up with, so every frame is written
+        exporter.reset(new TimeLapseExporter(format, fps, buffers, TimeLapseExporter::Overflow::Wait));
+        if (!exporter->open(path))
+        {
+            err << "Could not open " << path << " for writing\n";
+            return 1;
+        }
+    }
+
+    // Optional telemetry, the first client gets the starting field
+    QScopedPointer<TelemetryServer> telemetry;
+    if (parser.isSet(telemetryOption))
+    {
+        QString errorMessage;
+        telemetry.reset(new TelemetryServer());
+        if (!telemetry->listen(parser.value(telemetryOption), &errorMessage))
+        {
+            err << errorMessage << "\n";
+            return 1;
+        }
+        if (!telemetry->waitForClient(10000))
+        {
+            err << "No telemetry client connected, running without one\n";
+        }
+    }
+
+    // Simulate days back to back, the first frame shows the starting field
+    QElapsedTimer timer;
+    timer.start();
+    if (exporter)
+    {
+        exporter->submitFrame(simulation);
+    }
+    if (telemetry)
+    {
+        telemetry->publish(simulation);
+    }
+    // Only the simulated days are counted, not exporting or telemetry
+    quint64 allocations = 0;
+    for (int day = 1; day <= days; ++day)
+    {
+        quint64 allocationsBefore = AllocationTracker::threadAllocations();
+        simulation.herdDay();
+        simulation.growthDay();
+        allocations += AllocationTracker::threadAllocations() - allocationsBefore;
+        if (exporter && day % every == 0)
+        {
+            exporter->submitFrame(simulation);
+        }
+        if (telemetry)
+        {
+            // There is no event loop, so socket writes and connections are handled here
+            telemetry->publish(simulation);
+            QCoreApplication::processEvents();
+        }
+    }
+    qint64 simulationNanoseconds = timer.nsecsElapsed();
+    if (exporter)
+    {
+        exporter->finish();
+    }
+    if (telemetry)
+    {
+        telemetry->finish(simulation, 10000);
+    }
+
+    // Report goes to stderr when stdout carries the video
+    FILE* reportFile = exporter && path == "-" ? stderr : stdout;
+    QTextStream report(reportFile);
+
+    double seconds = qMax(simulationNanoseconds, qint64(1)) / 1e9;
+    const PastureGrid& grid = simulation.getGrid();
+    double cells = static_cast<double>(grid.width()) * grid.height();
+    long peakRss = peakResidentKilobytes();
+
+    report << "Days:           " << days << "\n";
+    report << "Time:           " << QString::number(seconds * 1000, 'f', 1) << " ms\n";
+    report << "Days/s:         " << QString::number(days / seconds, 'f', 0) << "\n";
+    report << "Cells/s:        " << QString::number(cells * days / seconds, 'e', 3) << "\n";
+    report << "Peak RSS:       " << (peakRss < 0 ? QString("n/a") : QString("%1 KiB").arg(peakRss)) << "\n";
+    report << "Field:          " << grid.width() << "x" << grid.height() << " cells\n";
+    report << "Herd:           " << simulation.getHerdWidth() << "x" << simulation.getHerdHeight()
+           << " at (" << simulation.getHerdX() << ", " << simulation.getHerdY() << "), speed "
+           << simulation.getHerdSpeed() << "\n";
+    if (simulation.getGrowthMode() == GameSimulation::GrowthMode::Spreading)
+    {
+        const SpreadingGrowth::Settings& spread = simulation.getSpreadSettings();
+        report << "Growth:         spreading, " << spread.neighbours << " neighbours, seed "
+               << spread.seedRate << "/16, spread " << spread.spreadRate << "/16, "
+               << spread.threads << " threads\n";
+    }
+    else
+    {
+        report << "Growth:         " << simulation.getGrowthAmount() << "/day\n";
+    }
+    report << "Money:          " << QString::number(simulation.getMoney(), 'f', 2) << "\n";
+    report << "Total money:    " << QString::number(simulation.getTotalMoney(), 'f', 2) << "\n";
+    report << "Total cleared:  " << QString::number(simulation.getTotalCleared(), 'f', 0) << "\n";
+    if (AllocationTracker::isEnabled())
+    {
+        report << "Allocations:    " << allocations << " in " << days << " days\n";
+    }
+    if (exporter)
+    {
+        report << "Frames written: " << exporter->getFramesWritten() << "\n";
+        report << "Frames dropped: " << exporter->getFramesDropped() << "\n";
+    }
+    if (telemetry)
+    {
+        report << "Telemetry:      " << telemetry->getMessagesSent() << " messages, "
+               << telemetry->getBytesSent() << " bytes, "
+               << telemetry->getUpdatesSkipped() << " coalesced\n";
+    }
+
+    // A time-lapse with missing frames is not a usable export
+    if (exporter && exporter->getFramesDropped() > 0)
+    {
+        err << "Export incomplete: " << exporter->getFramesDropped() << " frames dropped\n";
+        return 3;
+    }
+
+    // Steady state days must not touch the heap
+    if (parser.isSet(checkAllocationsOption) && allocations > 0)
+    {
+        err << "Allocation check failed: " << allocations << " allocations while simulating\n";
+        return 2;
+    }
+    return 0;
+}
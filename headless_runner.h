@@ -0,0 +1,18 @@
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#include <QStringList>      // Command line arguments
+
+// Runs the game from the command line without a window
+// Days are simulated back to back, as fast as the machine allows
+class HeadlessRunner
+{
+public:
+    // Checks the raw arguments for a headless option before any application exists
+    static bool isRequested(int argc, char *argv[]);
+
+    // Runs the requested headless mode and returns the process exit code
+    static int run(const QStringList& arguments);
+};
+
+#endif // HEADLESS_RUNNER_H
@@ -2,80 +2,68 @@
 #include <QPainter>        // For custom drawing
 #include <QDateTime>       // For time calculations
 #include <QDebug>          // For debug output
+#include "allocation_tracker.h" // For the allocation counter label
+#include <QMouseEvent>     // For panning the field view
+#include <QWheelEvent>     // For zooming the field view
 #include <cmath>           // For math functions
-#include <functional>      // For std::function
-
-
-// Field sizes vector declaration
-// Larger numbers are more zoomed out
-const QVector<int> Herd_of_Grazing_Cows::fieldSizes = {50, 25, 20, 10, 5, 4, 2, 1};
-const QVector<int> GameDisplayWidget::fieldSizes = {50, 25, 20, 10, 5, 4, 2, 1};
-
-// Upgrade implementation
-// Constructor to initialize all upgrade variables
-Herd_of_Grazing_Cows::Upgrade::Upgrade(const QString& name, double price, double multiplier,
-                                std::function<void()> onBuy, const QString& displayText,
-                                const QString& displayName, std::function<bool()> canBuy)
-    : name(name), displayName(displayName), displayText(displayText),
-    price(price), multiplier(multiplier), onBuy(onBuy), canBuy(canBuy), level(0)
-{}
-
-
-// Applies upgrade purchase effects and increases price
-void Herd_of_Grazing_Cows::Upgrade::buy()
-{
-    // Check if upgrade can be purchased
-    if (canBuy())
-    {
-        onBuy();                // Execute the upgrade effect
-        level++;                // Increase upgrade level
-        price *= multiplier;    // Increase price for next purchase
-    }
-}
-
-// Gets display text for UI
-QString Herd_of_Grazing_Cows::Upgrade::getDisplayText() const
-{
-    return displayText;
-}
 
 
 // Main class constructor
 Herd_of_Grazing_Cows::Herd_of_Grazing_Cows(QWidget *parent)
     : QMainWindow(parent),                              // Initialize base QMainWindow class
-    // Initialize all game state variables
-    money(0), totalMoney(0),                            // Start with no money
-    herdX(0), herdY(0),                                 // Herd starts at top left
-    herdWidth(1), herdHeight(1),                        // Herd starts as 1 cow by 1 cow
-    herdSpeed(1),                                       // 1 acre per day
-    herdDirectionUp(false),                             // Start moving down
-    growthAmount(4),                                    // 4 growth actions per day
-    fieldSize(0),                                       // Start with largest field size
-    dayRate(1000),                                      // 1 second per game day
-    totalCleared(0),                                    // No grass cleared yet
-    lastDay(0), superExtra(0), superDays(0),            // Time tracking
     gameDisplayWidget(nullptr), centralWidget(nullptr)  // UI
 {
     setFixedSize(800, 600); // Window size 800x600 pixels
 
     // Create game systems
-    initializeGame();      // Set up initial game state
-    initializeUpgrades();  // Create all available upgrades
     createUI();            // Build the UI
 
+    // Game work runs in slices, highest priority first
+    scheduler = new FrameScheduler(16, 8, this);
+    scheduler->setTask(FrameScheduler::Input, [this]() { return inputTask(); });
+    scheduler->setTask(FrameScheduler::Herd, [this]() { return herdTask(); });
+    scheduler->setTask(FrameScheduler::Growth, [this]() { return growthTask(); });
+    scheduler->setTask(FrameScheduler::Stats, [this]() { return statsTask(); });
+    scheduler->setTask(FrameScheduler::Paint, [this]() { return paintTask(); });
+
     // Set up timer
     gameTimer = new QTimer(this);
     // Connect timer to gameUpdate
     connect(gameTimer, &QTimer::timeout, this, &Herd_of_Grazing_Cows::gameUpdate);
     // Sets timer to current dayRate
-    gameTimer->start(dayRate);
+    gameTimer->start(simulation.getDayRate());
 }
 
-// Destructor to delete allocated memory
+// Destructor
 Herd_of_Grazing_Cows::~Herd_of_Grazing_Cows()
 {
-    // Delete upgrades to prevent memory leak
-    qDeleteAll(upgrades);
+    // Upgrades are owned and deleted by the simulation
+}
+
+// Starts the telemetry server
+bool Herd_of_Grazing_Cows::startTelemetry(const QString& name, QString* errorMessage)
+{
+    // Owned by the window through its parent
+    TelemetryServer* server = new TelemetryServer(this);
+    if (!server->listen(name, errorMessage))
+    {
+        delete server;
+        return false;
+    }
+    delete telemetry;
+    telemetry = server;
+    return true;
+}
+
+// Moves the field into a pasture file and shows it
+bool Herd_of_Grazing_Cows::usePastureFile(const QString& path, QString* errorMessage)
+{
+    if (!simulation.usePastureFile(path, errorMessage))
+    {
+        return false;
+    }
+    scheduler->wake(FrameScheduler::Paint);
+    return true;
 }
 
 // Creates UI
@@ -91,7 +79,7 @@ void Herd_of_Grazing_Cows::createUI()
 
     // Left side game display
     gameDisplayWidget = new GameDisplayWidget(centralWidget);
-    gameDisplayWidget->setFixedSize(width , height);
+    gameDisplayWidget->setFixedSize(GameSimulation::width, GameSimulation::height);
 
     // Right side controls and info
     QWidget* controlPanel = new QWidget(centralWidget);
@@ -109,6 +97,7 @@ void Herd_of_Grazing_Cows::createUI()
     growthLabel = new QLabel("Growth Rate: 4", this);
     dayRateLabel = new QLabel("Day Rate: 1000ms", this);
     superDaysLabel = new QLabel("", this);
+    superDaysLabel->setStyleSheet("color: red; font-weight: bold;");  // Highlight
 
     // Add labels to stats layout
     statsLayout->addWidget(moneyLabel);
@@ -119,6 +108,18 @@ void Herd_of_Grazing_Cows::createUI()
     statsLayout->addWidget(dayRateLabel);
     statsLayout->addWidget(superDaysLabel);
 
+    // Growth mode, random cells or spreading from neighbours
+    spreadingCheckBox = new QCheckBox("Spreading Growth", this);
+    connect(spreadingCheckBox, &QCheckBox::toggled, this, &Herd_of_Grazing_Cows::setSpreadingGrowth);
+    statsLayout->addWidget(spreadingCheckBox);
+
+    // Allocation counter only exists in builds that track allocations
+    if (AllocationTracker::isEnabled())
+    {
+        allocationsLabel = new QLabel("Allocations/Frame: 0", this);
+        statsLayout->addWidget(allocationsLabel);
+    }
+
     // Upgrades group
     QGroupBox* upgradesGroup = new QGroupBox("Upgrades", this);
     QVBoxLayout* upgradesLayout = new QVBoxLayout(upgradesGroup);
@@ -150,6 +151,15 @@ void Herd_of_Grazing_Cows::createUI()
     upgradesLayout->addWidget(growthUpgradeButton);
     upgradesLayout->addWidget(dayUpgradeButton);
 
+    // Look up each upgrade once instead of on every tick
+    upgradeButtons = {
+        {speedUpgradeButton, simulation.getUpgrade("herdSpeed"), "Herd Speed Upgrade"},
+        {sizeUpgradeButton, simulation.getUpgrade("herdSize"), "Herd Size Upgrade"},
+        {fieldUpgradeButton, simulation.getUpgrade("fieldSize"), "Field Size Upgrade"},
+        {growthUpgradeButton, simulation.getUpgrade("growthRate"), "Growth Rate Upgrade"},
+        {dayUpgradeButton, simulation.getUpgrade("dayRate"), "Day Rate Upgrade"},
+    };
+
     // Add groups to control layout
     controlLayout->addWidget(statsGroup);
     controlLayout->addWidget(upgradesGroup);
@@ -160,477 +170,257 @@ void Herd_of_Grazing_Cows::createUI()
     mainLayout->addWidget(controlPanel);
 }
 
-// Initialize game function
-void Herd_of_Grazing_Cows::initializeGame()
+// Called by timer to queue a game day
+// The day itself is done by the scheduler tasks below
+void Herd_of_Grazing_Cows::gameUpdate()
 {
-    generateField();                               // Creates initial field
-    lastDay = QDateTime::currentMSecsSinceEpoch(); // QDateTime function to return current miliseconds
+    simulation.trackTime(QDateTime::currentMSecsSinceEpoch()); // Turn lag into super days
+    pendingDays++;
+    scheduler->wake(FrameScheduler::Herd);
 }
 
-// Initialize upgrades function
-void Herd_of_Grazing_Cows::initializeUpgrades()
+// Buys the upgrades clicked since the last frame
+// Runs before any game work, so a click is answered in the next frame
+// A purchase can change the field or the herd, so it waits for a running
+// day to finish, the growth task wakes this task again when it does
+bool Herd_of_Grazing_Cows::inputTask()
 {
-    // Herd speed upgrade
-    // Increases how many moves the herd makes per day
-    upgrades.append(new Upgrade(
-        "herdSpeed",           // Internal name
-        speedBasePrice,        // Starting price: $50
-        speedMultiplier,       // Price multiplier: 2.0 (doubles each purchase)
-        [this](){ this->herdSpeed++; },  // Effect: increase herd speed by 1
-        "acres/day",           // Display text
-        "Herd Speed",          // User friendly name
-        [this](){ return this->herdSpeed < 50; }  // Can buy until speed reaches 50
-        ));
-
-    // herd size upgrade
-    // Increases the area the herd covers when moving
-    upgrades.append(new Upgrade(
-        "herdSize",
-        sizeBasePrice,         // Starting price: $75
-        sizeMultiplier,        // Price multiplier: 1.3 (30% increase)
-        [this]()
-        {
-            // Alternate between increasing width and height
-            if (this->herdWidth == this->herdHeight) {
-                this->herdWidth++;   // Increase width if square
-            }
-            else
-            {
-                this->herdHeight++;  // Increase height if rectangular
-            }
-            // Reset position to top-left when size changes
-            this->herdX = 0;
-            this->herdY = 0;
-        },
-        "size",                // Display text
-        "Herd Size",           // User friendly name
-        [this]()
-        {
-            // Can't exceed field boundaries
-            int maxSize = height / fieldSizes[this->fieldSize];
-            return this->herdHeight < maxSize && this->herdWidth < maxSize;
-        }
-        ));
-
-    // field size upgrade
-    // Changes the zoom level
-    upgrades.append(new Upgrade(
-        "fieldSize",
-        fieldBasePrice,        // Starting price: $150
-        fieldMultiplier,       // Price multiplier: 2.5 (150% increase)
-        [this]() {
-            // Increase field size index (makes cells smaller)
-            this->fieldSize = qMin(this->fieldSize + 1, fieldSizes.size() - 1);
-            this->regenerateField();  // Recreate field with new cell size
-        },
-        "field size",          // Display text
-        "Field Size",          // User friendly name
-        [this]() {
-            // Can buy until reaching smallest field size
-            return this->fieldSize < fieldSizes.size() - 1;
-        }
-        ));
-
-    // growth rate upgrade
-    // Increases how much grass grows per day
-    upgrades.append(new Upgrade(
-        "growthRate",
-        growthBasePrice,       // Starting price: $10
-        growthMultiplier,      // Price multiplier: 1.15 (15% increase)
-        [this]()
-        {
-            this->growthAmount += 2;  // Increase growth by 2 units per day
-        },
-        "growth/day",          // Display text
-        "Growth Rate",         // User friendly name
-        [this]()
-        {
-            // Can buy until growth reaches 100 per day
-            return this->growthAmount < 100;
-        }
-        ));
-
+    if (simulation.isDayRunning())
+    {
+        return false;
+    }
 
+    for (const QString& name : pendingPurchases)
+    {
+        simulation.buyUpgrade(name);
+    }
+    pendingPurchases.clear();
 
-    // day rate upgrade
-    // Speeds up the game by reducing time between days
-    upgrades.append(new Upgrade(
-        "dayRate",
-        dayBasePrice,          // Starting price: $5
-        dayMultiplier,         // Price multiplier: 1.15 (15% increase)
-        [this]()
-        {
-            // Reduce day rate by 15%, minimum 1ms
-            this->dayRate = qMax(1, static_cast<int>(this->dayRate * 0.85));
-        },
-        "ms",                  // Display text
-        "Day Rate",            // User friendly name
-        [this]()
-        {
-            // Can buy until day rate reaches 1ms
-            return this->dayRate > 1;
-        }
-        ));
+    // Show the result right away, a new field also needs a repaint
+    updateUI();
+    scheduler->wake(FrameScheduler::Paint);
+    return false;
 }
 
-// generate field function to create the field
-void Herd_of_Grazing_Cows::generateField()
+// Starts queued days and makes herd moves until the frame budget is used up
+bool Herd_of_Grazing_Cows::herdTask()
 {
-    // Calculate grid dimensions based on current field size
-    int gridWidth = width / fieldSizes[fieldSize];
-    int gridHeight = height / fieldSizes[fieldSize];
-
-    // Resize the grid to match dimensions
-    grid.resize(gridWidth);
-    for (int i = 0; i < gridWidth; ++i)
+    // The next day starts once the last one has finished growing
+    if (!simulation.isDayRunning())
     {
-        grid[i].resize(gridHeight);  // Set up each column
-        for (int j = 0; j < gridHeight; ++j)
+        if (pendingDays == 0)
         {
-            // Initialize each cell with random growth level
-            grid[i][j] = rand() % maxGrowth;
+            return false;
         }
+        pendingDays--;
+        simulation.beginDay();
     }
-}
 
+    bool herdDone = simulation.stepHerd(herdSlice);
+    while (!herdDone && scheduler->hasTimeLeft())
+    {
+        herdDone = simulation.stepHerd(herdSlice);
+    }
 
-// Regenerate field function when field size changes
-void Herd_of_Grazing_Cows::regenerateField()
-{
-    grid.clear();       // Clears field
-    generateField();    // Create new field
+    if (!herdDone)
+    {
+        return true;  // Carries on next frame
+    }
+    scheduler->wake(FrameScheduler::Growth);
+    return false;
 }
 
-// All herd activity for one day
-void Herd_of_Grazing_Cows::herdDay()
+// Grows grass until the frame budget is used up, then finishes the day
+bool Herd_of_Grazing_Cows::growthTask()
 {
-    // Gets time since last day
-    qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
-    qint64 timeDifference = currentTime - lastDay;
-    lastDay = currentTime;
-
-    // Uses extra time for super days
-    superExtra += timeDifference - dayRate;
-    if (superExtra > dayRate * 5)
+    bool growthDone = simulation.stepGrowth(growthSlice);
+    while (!growthDone && scheduler->hasTimeLeft())
     {
-        superDays += static_cast<int>(superExtra / 5 / dayRate);
-        superExtra = fmod(superExtra, dayRate * 5);
+        growthDone = simulation.stepGrowth(growthSlice);
     }
 
-    // Gets current grid dimensions
-    int gridWidth = width / fieldSizes[fieldSize];
-    int gridHeight = height / fieldSizes[fieldSize];
-
-    // Herd movements and grass clearing
-    // Number of moves based on herd speed
-    for (int i = 0; i < herdSpeed; ++i)
+    if (!growthDone)
     {
-
-        for (int x = 0; x < herdWidth; ++x)
-        {
-            for (int y = 0; y < herdHeight; ++y)
-            {
-                // Get real herd position
-                int tX = x + herdX;
-                int tY = y + herdY;
-
-                // Check if position is valid and grass is grown
-                if (tX < gridWidth && tY < gridHeight && grid[tX][tY] >= 5)
-                {
-                    // Clears grass
-                    grid[tX][tY] = 0;
-                    // Gets money
-                    double value = 1.0 * (superDays > 0 ? 5 : 1);
-                    money += value;
-                    totalMoney += value;
-                    totalCleared++;
-
-                    // Use up a super day if it is active
-                    if (superDays > 0)
-                    {
-                        superDays--;
-                    }
-                }
-            }
-        }
-
-        // Herd movement pattern
-        if (herdDirectionUp)  // Moving upward
-        {
-            if (herdY > 0)  // Can move up
-            {
-                herdY--;
-            }
-            else if (herdX >= gridWidth - herdWidth)  // At top and right edge
-            {
-                // Reset to start position
-                herdDirectionUp = false;
-                herdX = 0;
-                herdY = 0;
-            }
-            else  // At top but not at right edge
-            {
-                // Move right and start moving down
-                herdX = qMin(herdX + herdWidth, gridWidth - herdWidth);
-                herdDirectionUp = false;
-            }
-        }
-        else  // Moving downward
-        {
-            if (herdY < gridHeight - herdHeight)  // Can move down
-            {
-                herdY++;
-            }
-            else if (herdX >= gridWidth - herdWidth)  // At bottom and right edge
-            {
-                // Reset to start position
-                herdDirectionUp = false;
-                herdX = 0;
-                herdY = 0;
-            }
-            else  // At bottom but not at right edge
-            {
-                // Move right and start moving up
-                herdX = qMin(herdX + herdWidth, gridWidth - herdWidth);
-                herdDirectionUp = true;
-            }
-        }
+        return true;  // Carries on next frame
     }
 
-    // Update UI for all herd/day changes
-    updateUI();
-}
-
-// Processes grass growth for one day
-void Herd_of_Grazing_Cows::growthDay()
-{
-    int gridWidth = width / fieldSizes[fieldSize];
-    int gridHeight = height / fieldSizes[fieldSize];
-
-    // Grow grass multiple times based on growth rate
-    for (int i = 0; i < growthAmount; ++i)
+    // Day finished, purchases clicked during it go first
+    if (!pendingPurchases.isEmpty())
+    {
+        scheduler->wake(FrameScheduler::Input);
+    }
+    scheduler->wake(FrameScheduler::Stats);
+    scheduler->wake(FrameScheduler::Paint);
+    if (pendingDays > 0)
     {
-        // Pick a random cell to grow
-        int x = rand() % gridWidth;
-        int y = rand() % gridHeight;
+        scheduler->wake(FrameScheduler::Herd);
+    }
 
-        // If grass isn't fully grown, increase its growth level
-        if (grid[x][y] < maxGrowth)
-        {
-            grid[x][y] = qMin(maxGrowth, grid[x][y] + 1);
-        }
+    // Send changes to telemetry clients, this never waits for them
+    if (telemetry)
+    {
+        telemetry->publish(simulation);
     }
+    return false;
 }
 
-
-// Called by timer to advance game state
-void Herd_of_Grazing_Cows::gameUpdate()
+// Refreshes labels and buttons
+bool Herd_of_Grazing_Cows::statsTask()
 {
-    herdDay();    // Handle herd movement and grass clearing
-    growthDay();  // Handle grass growth
+    updateUI();
+    return false;
+}
 
-    // Update visual display with current game state
+// Update visual display with current game state
+bool Herd_of_Grazing_Cows::paintTask()
+{
     if (gameDisplayWidget)
     {
-        gameDisplayWidget->setGameData(&grid, fieldSize, herdX, herdY, herdWidth, herdHeight);
+        gameDisplayWidget->setGameData(&simulation.getGrid(), simulation.getHerdX(), simulation.getHerdY(),
+                                       simulation.getHerdWidth(), simulation.getHerdHeight());
     }
+    return false;
+}
 
-    // Refresh UI elements
-    updateUI();
+// Queues an upgrade purchase for the input task
+void Herd_of_Grazing_Cows::requestUpgrade(const QString& name)
+{
+    pendingPurchases.append(name);
+    scheduler->wake(FrameScheduler::Input);
 }
 
 // Function to update all UI
+// Text is only rebuilt for values that changed since the last update
 void Herd_of_Grazing_Cows::updateUI()
 {
     // update labels
-    moneyLabel->setText(QString("Money: $%1").arg(money, 0, 'f', 2));
-    totalClearedLabel->setText(QString("Total Cleared: %1").arg(totalCleared, 0, 'f', 0));
-    speedLabel->setText(QString("Herd Speed: %1").arg(herdSpeed));
-    sizeLabel->setText(QString("Herd Size: %1x%2").arg(herdWidth).arg(herdHeight));
-    growthLabel->setText(QString("Growth Rate: %1").arg(growthAmount));
-    dayRateLabel->setText(QString("Day Rate: %1ms").arg(dayRate));
+    if (simulation.getMoney() != shownMoney)
+    {
+        shownMoney = simulation.getMoney();
+        moneyLabel->setText(QString("Money: $%1").arg(shownMoney, 0, 'f', 2));
+    }
+    if (simulation.getTotalCleared() != shownTotalCleared)
+    {
+        shownTotalCleared = simulation.getTotalCleared();
+        totalClearedLabel->setText(QString("Total Cleared: %1").arg(shownTotalCleared, 0, 'f', 0));
+    }
+    if (simulation.getHerdSpeed() != shownSpeed)
+    {
+        shownSpeed = simulation.getHerdSpeed();
+        speedLabel->setText(QString("Herd Speed: %1").arg(shownSpeed));
+    }
+    if (simulation.getHerdWidth() != shownWidth || simulation.getHerdHeight() != shownHeight)
+    {
+        shownWidth = simulation.getHerdWidth();
+        shownHeight = simulation.getHerdHeight();
+        sizeLabel->setText(QString("Herd Size: %1x%2").arg(shownWidth).arg(shownHeight));
+    }
+    if (simulation.getGrowthAmount() != shownGrowth)
+    {
+        shownGrowth = simulation.getGrowthAmount();
+        growthLabel->setText(QString("Growth Rate: %1").arg(shownGrowth));
+    }
+    if (simulation.getDayRate() != shownDayRate)
+    {
+        shownDayRate = simulation.getDayRate();
+        dayRateLabel->setText(QString("Day Rate: %1ms").arg(shownDayRate));
+    }
 
     // Show super days count if any are active
-    if (superDays > 0)
+    if (simulation.getSuperDays() != shownSuperDays)
     {
-        superDaysLabel->setText(QString("SUPER DAYS: %1").arg(superDays));
-        superDaysLabel->setStyleSheet("color: red; font-weight: bold;");  // Highlight
+        shownSuperDays = simulation.getSuperDays();
+        if (shownSuperDays > 0)
+        {
+            superDaysLabel->setText(QString("SUPER DAYS: %1").arg(shownSuperDays));
+        }
+        else
+        {
+            superDaysLabel->clear();  // Hide when no super days
+        }
     }
-    else
+
+    // Allocations made by every task in the last frame, game work and UI alike
+    if (allocationsLabel && scheduler->getLastFrameAllocations() != shownAllocations)
     {
-        superDaysLabel->setText("");  // Hide when no super days
+        shownAllocations = scheduler->getLastFrameAllocations();
+        allocationsLabel->setText(QString("Allocations/Frame: %1").arg(shownAllocations));
     }
 
     // Update upgrade buttons
-    // For each upgrade, update button text and enable/disable state
-
-    // Herd Speed Upgrade Button
-    Upgrade* speedUpgrade = getUpgrade("herdSpeed");
-    if (speedUpgrade)
-    {
-        // Set button text with current price and level
-        QString buttonText = speedUpgrade->canBuy() ?
-                                 QString("Herd Speed Upgrade: $%1 (Lvl %2)")
-                                     .arg(speedUpgrade->price, 0, 'f', 0)
-                                     .arg(speedUpgrade->level) :
-                                 "Herd Speed Upgrade: MAXED";
-        speedUpgradeButton->setText(buttonText);
-
-        // Enable button only if upgrade is available and affordable
-        speedUpgradeButton->setEnabled(speedUpgrade->canBuy() && money >= speedUpgrade->price);
-    }
-    // same logic is applied for all upgrades
-
-    // Herd Size Upgrade Button
-    Upgrade* sizeUpgrade = getUpgrade("herdSize");
-    if (sizeUpgrade)
-    {
-        QString buttonText = sizeUpgrade->canBuy() ?
-                                 QString("Herd Size Upgrade: $%1 (Lvl %2)")
-                                     .arg(sizeUpgrade->price, 0, 'f', 0)
-                                     .arg(sizeUpgrade->level) :
-                                 "Herd Size Upgrade: MAXED";
-        sizeUpgradeButton->setText(buttonText);
-        sizeUpgradeButton->setEnabled(sizeUpgrade->canBuy() && money >= sizeUpgrade->price);
-    }
-
-    // Field Size Upgrade Button
-    Upgrade* fieldUpgrade = getUpgrade("fieldSize");
-    if (fieldUpgrade)
-    {
-        QString buttonText = fieldUpgrade->canBuy() ?
-                                 QString("Field Size Upgrade: $%1 (Lvl %2)")
-                                     .arg(fieldUpgrade->price, 0, 'f', 0)
-                                     .arg(fieldUpgrade->level) :
-                                 "Field Size Upgrade: MAXED";
-        fieldUpgradeButton->setText(buttonText);
-        fieldUpgradeButton->setEnabled(fieldUpgrade->canBuy() && money >= fieldUpgrade->price);
-    }
-
-    // Growth Rate Upgrade Button
-    Upgrade* growthUpgrade = getUpgrade("growthRate");
-    if (growthUpgrade)
-    {
-        QString buttonText = growthUpgrade->canBuy() ?
-                                 QString("Growth Rate Upgrade: $%1 (Lvl %2)")
-                                     .arg(growthUpgrade->price, 0, 'f', 0)
-                                     .arg(growthUpgrade->level) :
-                                 "Growth Rate Upgrade: MAXED";
-        growthUpgradeButton->setText(buttonText);
-        growthUpgradeButton->setEnabled(growthUpgrade->canBuy() && money >= growthUpgrade->price);
-    }
-
-    // Day Rate Upgrade Button
-    Upgrade* dayUpgrade = getUpgrade("dayRate");
-    if (dayUpgrade)
-    {
-        QString buttonText = dayUpgrade->canBuy() ?
-                                 QString("Day Rate Upgrade: $%1 (Lvl %2)")
-                                     .arg(dayUpgrade->price, 0, 'f', 0)
-                                     .arg(dayUpgrade->level) :
-                                 "Day Rate Upgrade: MAXED";
-        dayUpgradeButton->setText(buttonText);
-        dayUpgradeButton->setEnabled(dayUpgrade->canBuy() && money >= dayUpgrade->price);
+    for (UpgradeButton& upgradeButton : upgradeButtons)
+    {
+        updateUpgradeButton(upgradeButton);
     }
 }
 
-// Get upgrade by its internal name
-Herd_of_Grazing_Cows::Upgrade* Herd_of_Grazing_Cows::getUpgrade(const QString& name)
+// Updates the text and enabled state of one upgrade button
+void Herd_of_Grazing_Cows::updateUpgradeButton(UpgradeButton& upgradeButton)
 {
-    // Searches all upgrades
-    for (Upgrade* upgrade : upgrades)
+    GameSimulation::Upgrade* upgrade = upgradeButton.upgrade;
+    if (!upgrade)
     {
-        if (upgrade->name == name)
-        {
-            return upgrade;
-        }
+        return;
+    }
+
+    // Set button text with current price and level
+    bool maxed = !upgrade->canBuy();
+    if (maxed != upgradeButton.shownMaxed || upgrade->price != upgradeButton.shownPrice
+        || upgrade->level != upgradeButton.shownLevel)
+    {
+        upgradeButton.shownMaxed = maxed;
+        upgradeButton.shownPrice = upgrade->price;
+        upgradeButton.shownLevel = upgrade->level;
+        upgradeButton.button->setText(maxed ? upgradeButton.title + ": MAXED"
+                                            : QString("%1: $%2 (Lvl %3)")
+                                                  .arg(upgradeButton.title)
+                                                  .arg(upgrade->price, 0, 'f', 0)
+                                                  .arg(upgrade->level));
     }
-    return nullptr; // Returns nothing if upgrade is not found
+
+    // Enable button only if upgrade is available and affordable
+    upgradeButton.button->setEnabled(!maxed && simulation.getMoney() >= upgrade->price);
 }
 
-// The following buy upgrade functions use previous get upgrade function
+// The following buy upgrade functions use the simulation's buy upgrade function
 // All are called when the upgrade buttons are clicked
 
 // Purchase herd speed upgrade
 void Herd_of_Grazing_Cows::buySpeedUpgrade()
 {
-    if (Upgrade* upgrade = getUpgrade("herdSpeed"))
-    {
-        // Check if player can afford and upgrade is available
-        if (money >= upgrade->price && upgrade->canBuy())
-        {
-            upgrade->buy();          // Apply upgrade effects
-            money -= upgrade->price; // Deduct cost
-            if(money < 0)            // Safety check (shouldn't happen)
-                money = 0;
-            updateUI();              // Refresh display
-        }
-    }
+    requestUpgrade("herdSpeed");  // Bought in the next frame
 }
 // logic is the same for all other buyUpgrade functions
 
 // Purchase herd size upgrade
 void Herd_of_Grazing_Cows::buySizeUpgrade()
 {
-    if (Upgrade* upgrade = getUpgrade("herdSize"))
-    {
-        if (money >= upgrade->price && upgrade->canBuy())
-        {
-            upgrade->buy();
-            money -= upgrade->price;
-            if(money < 0)
-                money = 0;
-            updateUI();
-        }
-    }
+    requestUpgrade("herdSize");
 }
 
 // Purchase field size upgrade
 void Herd_of_Grazing_Cows::buyFieldUpgrade()
 {
-    if (Upgrade* upgrade = getUpgrade("fieldSize"))
-    {
-        if (money >= upgrade->price && upgrade->canBuy())
-        {
-            upgrade->buy();
-            money -= upgrade->price;
-            if(money < 0)
-                money = 0;
-            updateUI();
-        }
-    }
+    requestUpgrade("fieldSize");
 }
 
 // Purchase growth rate upgrade
 void Herd_of_Grazing_Cows::buyGrowthUpgrade()
 {
-    if (Upgrade* upgrade = getUpgrade("growthRate"))
-    {
-        if (money >= upgrade->price && upgrade->canBuy())
-        {
-            upgrade->buy();
-            money -= upgrade->price;
-            if(money < 0)
-                money = 0;
-            updateUI();
-        }
-    }
+    requestUpgrade("growthRate");
 }
 
 // Purchase day rate upgrade
 void Herd_of_Grazing_Cows::buyDayUpgrade()
 {
-    if (Upgrade* upgrade = getUpgrade("dayRate"))
-    {
-        if (money >= upgrade->price && upgrade->canBuy())
-        {
-            upgrade->buy();
-            money -= upgrade->price;
-            if(money < 0)
-                money = 0;
-            updateUI();
-        }
-    }
+    requestUpgrade("dayRate");
+}
+
+// Switches the growth mode, the day in progress keeps its mode
+void Herd_of_Grazing_Cows::setSpreadingGrowth(bool spreading)
+{
+    simulation.setGrowthMode(spreading ? GameSimulation::GrowthMode::Spreading
+                                       : GameSimulation::GrowthMode::Random);
 }
 
 
@@ -640,3 +430,164 @@ void Herd_of_Grazing_Cows::paintEvent(QPaintEvent* event)
     // Empty because drawing is handled by the GameDisplayWidget class
     QPainter painter(this);
 }
+
+
+
+// GameDisplayWidget functions
+
+// Shows the whole field, this matches the field size in pixels
+void GameDisplayWidget::fitView()
+{
+    m_viewGridWidth = m_grid->width();
+    m_viewGridHeight = m_grid->height();
+    m_scale = qMin(static_cast<double>(width()) / m_viewGridWidth,
+                   static_cast<double>(height()) / m_viewGridHeight);
+    m_viewX = 0;
+    m_viewY = 0;
+}
+
+// Keeps at least half of the widget over the field
+void GameDisplayWidget::clampView()
+{
+    double visibleWidth = width() / m_scale;
+    double visibleHeight = height() / m_scale;
+    m_viewX = qBound(-visibleWidth / 2, m_viewX, m_viewGridWidth - visibleWidth / 2);
+    m_viewY = qBound(-visibleHeight / 2, m_viewY, m_viewGridHeight - visibleHeight / 2);
+}
+
+// Converts cell coordinates to widget pixels
+// Rounding down keeps neighbouring cells without gaps between them
+int GameDisplayWidget::toPixelX(double cellX) const
+{
+    return static_cast<int>(std::floor((cellX - m_viewX) * m_scale));
+}
+
+int GameDisplayWidget::toPixelY(double cellY) const
+{
+    return static_cast<int>(std::floor((cellY - m_viewY) * m_scale));
+}
+
+// Draws only the cells inside the widget
+// When zoomed out past one pixel per cell, blocks of cells are drawn from the mip
+// The cells and grid lines are drawn into one image by the rasterizer, only the herd is painted
+void GameDisplayWidget::paintEvent(QPaintEvent* event)
+{
+    // Marks event parameter as unused
+    Q_UNUSED(event);
+
+    // Creates a painter object to draw on this widget
+    QPainter painter(this);
+    // For smooth edges:
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    // If no grid data is available, only the empty green field is drawn
+    if (!m_grid || m_grid->isEmpty())
+    {
+        painter.fillRect(rect(), Qt::darkGreen);
+        return;
+    }
+
+    // Pick the level where a block of cells covers at least one pixel
+    int level = 0;
+    while ((1 << level) * m_scale < 1.0)
+    {
+        level++;
+    }
+    if (level > 0)
+    {
+        m_mip.update(*m_grid);
+        level = qMin(level, m_mip.levelCount());
+    }
+
+    // Draw grass fields, with dark green grid lines around the tiles
+    // Smaller tiles would be nothing but grid lines
+    PastureRasterizer::View view;
+    view.x = m_viewX;
+    view.y = m_viewY;
+    view.scale = m_scale;
+    view.level = level;
+    view.gridLines = level == 0 && m_scale >= 4;
+    painter.drawImage(0, 0, m_rasterizer.render(*m_grid, m_mip, view, size()));
+
+    // Draw herd as a brown rectangle
+    int herdLeft = toPixelX(m_herdX);
+    int herdTop = toPixelY(m_herdY);
+    int herdPixelWidth = toPixelX(m_herdX + m_herdWidth) - herdLeft;
+    int herdPixelHeight = toPixelY(m_herdY + m_herdHeight) - herdTop;
+    painter.fillRect(herdLeft, herdTop, herdPixelWidth, herdPixelHeight, QColor(101, 67, 33));
+
+    // Draw white border around the herd
+    painter.setPen(Qt::white);
+    painter.drawRect(herdLeft, herdTop, herdPixelWidth, herdPixelHeight);
+}
+
+// Zooms in or out, keeping the cell under the mouse in place
+void GameDisplayWidget::wheelEvent(QWheelEvent* event)
+{
+    if (!m_grid || m_grid->isEmpty())
+    {
+        return;
+    }
+
+    QPointF pos = event->position();
+    double cellX = m_viewX + pos.x() / m_scale;
+    double cellY = m_viewY + pos.y() / m_scale;
+
+    // One wheel step (120) zooms by about 20%, down to an eighth of the fitted size
+    double fitScale = qMin(static_cast<double>(width()) / m_viewGridWidth,
+                           static_cast<double>(height()) / m_viewGridHeight);
+    double factor = std::pow(1.0015, event->angleDelta().y());
+    m_scale = qBound(fitScale / 8, m_scale * factor, maxScale);
+
+    m_viewX = cellX - pos.x() / m_scale;
+    m_viewY = cellY - pos.y() / m_scale;
+    clampView();
+    update();
+    event->accept();
+}
+
+// Starts dragging the view with the left mouse button
+void GameDisplayWidget::mousePressEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        m_panning = true;
+        m_lastMousePos = QPointF(event->pos());
+    }
+}
+
+// Moves the view with the mouse while dragging
+void GameDisplayWidget::mouseMoveEvent(QMouseEvent* event)
+{
+    if (!m_panning || !m_grid)
+    {
+        return;
+    }
+
+    QPointF pos(event->pos());
+    m_viewX -= (pos.x() - m_lastMousePos.x()) / m_scale;
+    m_viewY -= (pos.y() - m_lastMousePos.y()) / m_scale;
+    m_lastMousePos = pos;
+    clampView();
+    update();
+}
+
+// Stops dragging the view
+void GameDisplayWidget::mouseReleaseEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        m_panning = false;
+    }
+}
+
+// Shows the whole field again
+void GameDisplayWidget::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    Q_UNUSED(event);
+    if (m_grid && !m_grid->isEmpty())
+    {
+        fitView();
+        update();
+    }
+}
@@ -4,13 +4,21 @@
 #include <QMainWindow>      // Main application window
 #include <QTimer>           // Timer for game updates
 #include <QVector>          // Dynamic array container
+#include <QStringList>      // Queued upgrade names
 #include <QColor>           // Color representation
 #include <QPushButton>      // Clickable button widget
 #include <QLabel>           // Text display widget
 #include <QVBoxLayout>      // Vertical layout manager
 #include <QHBoxLayout>      // Horizontal layout manager
 #include <QGroupBox>        // Group container with title
+#include <QCheckBox>        // Growth mode switch
 #include <QPainter>         // 2D painting functionality
+#include <QPointF>          // Mouse positions
+#include "game_simulation.h" // Game state and rules
+#include "pasture_mip.h"     // Zoomed out field levels
+#include "pasture_rasterizer.h" // Field image drawn in bands
+#include "telemetry_server.h" // Optional state stream
+#include "frame_scheduler.h"  // Game work spread over frames
 
 // Qt namespace declaration for UI classes
 QT_BEGIN_NAMESPACE
@@ -36,59 +44,21 @@ public:
     ~Herd_of_Grazing_Cows();
 
     // methods to get values for the game state
-    double getmoney() const { return money; }
-    double getTotalMoney() const { return totalMoney; }
+    double getmoney() const { return simulation.getMoney(); }
+    double getTotalMoney() const { return simulation.getTotalMoney(); }
+
+    // Streams the game state to a local socket from now on
+    bool startTelemetry(const QString& name, QString* errorMessage);
+
+    // Keeps the field in a memory-mapped pasture file
+    bool usePastureFile(const QString& path, QString* errorMessage);
 
 private:
     // default ui class pointer
     Ui::Herd_of_Grazing_Cows *ui;
 
-    // constant values
-    static const int width = 500;           // Game display width in pixels
-    static const int height = 500;          // Game display height in pixels
-    static constexpr int maxGrowth = 15;    // Maximum grass growth level
-    static const QVector<int> fieldSizes;   // Available field sizes for zoom levels
-
-    // money variables
-    double money;        // Current available money for purchases
-    double totalMoney;   // Total money earned over game lifetime
-
-    // forward declaration
-    struct Upgrade;
-
-    // herd values
-    QVector<QVector<int>> grid;  // 2D grid representing the field, each cell has grass growth level 0-15
-    int herdX, herdY;            // Current position of the herd, (0,0) is at the top-left corner
-    int herdWidth, herdHeight;   // Size of the herd in grid cells
-    int herdSpeed;               // How many moves the herd makes per day
-    bool herdDirectionUp;        // true = moving up, false = moving down
-
-    // field values
-    int growthAmount;    // How much grass grows per day
-    int fieldSize;       // Current zoom level for fieldSizes vector
-    int dayRate;         // Milliseconds between game days
-    double totalCleared; // Total number of grass tiles cleared over game lifetime
-
-    qint64 lastDay;      // Last time a game day was processed
-    double superExtra;   // Accumulated extra time for super days calculation
-    int superDays;       // Bonus days that give 5 times the money
-
-    // upgrades
-    QVector<Upgrade*> upgrades;  // List of available upgrades
-
-    // upgrade base prices
-    const double growthBasePrice = 10;   // Cost to increase growth rate
-    const double speedBasePrice = 50;    // Cost to increase herd speed
-    const double sizeBasePrice = 75;     // Cost to increase herd size
-    const double fieldBasePrice = 150;   // Cost to change field size
-    const double dayBasePrice = 5;       // Cost to speed up game days
-
-    // upgrade price multipliers
-    const double growthMultiplier = 1.15;  // 15% price increase
-    const double speedMultiplier = 2.0;    // 100% price increase
-    const double sizeMultiplier = 1.3;     // 30% price increase
-    const double fieldMultiplier = 2.5;    // 150% price increase
-    const double dayMultiplier = 1.15;     // 15% price increase
+    // game state, herd, field and upgrades
+    GameSimulation simulation;
 
     // UI
     GameDisplayWidget* gameDisplayWidget;  // Custom widget for game visual
@@ -102,6 +72,7 @@ private:
     QLabel* growthLabel = nullptr;        // Shows growth rate
     QLabel* dayRateLabel = nullptr;       // Shows game speed
     QLabel* superDaysLabel = nullptr;     // Shows bonus days count
+    QLabel* allocationsLabel = nullptr;   // Shows heap allocations in the last frame, if tracked
 
     // button widgets for upgrades
     QPushButton* speedUpgradeButton;   // Button to buy speed upgrade
@@ -110,51 +81,70 @@ private:
     QPushButton* growthUpgradeButton;  // Button to buy growth upgrade
     QPushButton* dayUpgradeButton;     // Button to buy day rate upgrade
 
-    // upgrade structure to define upgrades and how they behave
-    struct Upgrade {
-        // upgrade properties
-        QString name;                   // Internal identifier not seen in UI
-        QString displayName;            // Name in UI
-        QString displayText;            // Description text for UI
-        double price;                   // Current cost to purchase
-        double multiplier;              // Price increase multiplier after purchase
-        std::function<void()> onBuy;    // Function called when upgrade is purchased
-        std::function<bool()> canBuy;   // Function that checks if upgrade is available
-        int level;                      // Current upgrade level
-
-        // Constructor that initializes all upgrade properties
-        Upgrade(const QString& name, double price, double multiplier, std::function<void()> onBuy,
-                const QString& displayText, const QString& displayName, std::function<bool()> canBuy);
-
-        // Struct functions
-        void buy();                         // Applies the upgrade effects and increases price
-        QString getDisplayText() const;     // Returns the display text for UI
+    // Switches between random and spreading growth
+    QCheckBox* spreadingCheckBox = nullptr;
+
+    // upgrade button structure remembering what the button shows
+    // Building button text allocates, so it is only rebuilt when something changed
+    struct UpgradeButton {
+        QPushButton* button;                 // Button widget
+        GameSimulation::Upgrade* upgrade;    // Upgrade the button buys
+        QString title;                       // Text before the price, e.g. "Herd Speed Upgrade"
+        double shownPrice = -1;              // Price in the button text
+        int shownLevel = -1;                 // Level in the button text
+        bool shownMaxed = false;             // true if the button says MAXED
     };
-
-    // Game timer that triggers regular updates
+    QVector<UpgradeButton> upgradeButtons;  // All upgrade buttons
+
+    // Values the labels show, labels are only updated when these change
+    double shownMoney = -1;
+    double shownTotalCleared = -1;
+    int shownSpeed = -1;
+    int shownWidth = -1, shownHeight = -1;
+    int shownGrowth = -1;
+    int shownDayRate = -1;
+    int shownSuperDays = -1;
+    quint64 shownAllocations = 0;
+
+    // Telemetry stream, nullptr unless started
+    TelemetryServer* telemetry = nullptr;
+
+    // Game timer that queues a day every dayRate
     QTimer* gameTimer;
 
+    // Scheduler that does the queued work in slices, so clicks are answered within a frame
+    FrameScheduler* scheduler;
+    int pendingDays = 0;          // Days queued but not started yet
+    QStringList pendingPurchases; // Upgrades clicked, bought when no day is running
+
+    // Work done per slice before checking the frame budget
+    static const int herdSlice = 4096;    // Herd moves
+    static const int growthSlice = 4096;  // Growth actions
+
     // Game initialization functions
-    void initializeGame();      // Sets up initial game state
-    void initializeUpgrades();  // Creates all available upgrades
     void createUI();            // Builds the user interface
 
-    // Game logic functions
-    void generateField();                       // Creates a new field
-    void regenerateField();                     // Clears and recreates the field
-    void herdDay();                             // Processes herd movement and grass clearing per day
-    void growthDay();                           // Processes grass growth per day
-    Upgrade* getUpgrade(const QString& name);   // Finds upgrade by name
-    void updateUI();                             // Refreshes all UI elements
+    // UI functions
+    void updateUI();                                         // Refreshes all UI elements
+    void updateUpgradeButton(UpgradeButton& upgradeButton);  // Refreshes one upgrade button
+
+    // Scheduler tasks, each returns true while it has more work
+    bool inputTask();            // Buys clicked upgrades between days
+    bool herdTask();             // Starts queued days and makes herd moves
+    bool growthTask();           // Grows grass and finishes the day
+    bool statsTask();            // Refreshes labels and buttons
+    bool paintTask();            // Refreshes the field display
+    void requestUpgrade(const QString& name);  // Queues a purchase for the next frame
 
 // private slot functions initialization
 private slots:                   // All called automatically when signals are received
-    void gameUpdate();           // Called by timer to advance game state
+    void gameUpdate();           // Called by timer to queue a game day
     void buySpeedUpgrade();      // Called when speed upgrade button is clicked
     void buySizeUpgrade();       // Called when size upgrade button is clicked
     void buyFieldUpgrade();      // Called when field upgrade button is clicked
     void buyGrowthUpgrade();     // Called when growth upgrade button is clicked
     void buyDayUpgrade();        // Called when day rate upgrade button is clicked
+    void setSpreadingGrowth(bool spreading);  // Called when the growth mode check box changes
 
 // protected function initialization
 protected:
@@ -171,6 +161,8 @@ signals:                                // Emit signals for slots
 
 // GameDisplayWidget implementation
 // Custom widget responsible for visualizing the game state
+// The view can be panned by dragging and zoomed with the mouse wheel,
+// double click fits the whole field again
 class GameDisplayWidget : public QWidget
 {
     // Qt macro to include signals and slots
@@ -181,87 +173,59 @@ public:
     explicit GameDisplayWidget(QWidget *parent = nullptr) : QWidget(parent) {}
 
     // Called when game state changes to display updated game state
-    void setGameData(const QVector<QVector<int>>* grid, int fieldSize,
-                     int herdX, int herdY, int herdWidth, int herdHeight)
+    void setGameData(const PastureGrid* grid, int herdX, int herdY, int herdWidth, int herdHeight)
     {
         m_grid = grid;             // Pointer to the game grid
-        m_fieldSize = fieldSize;   // Current field size/zoom level
         m_herdX = herdX;           // Herd X position
         m_herdY = herdY;           // Herd Y position
         m_herdWidth = herdWidth;   // Herd width in cells
         m_herdHeight = herdHeight; // Herd height in cells
-        update();                  // Schedule a repaint
-    }
-
-protected:
-    void paintEvent(QPaintEvent* event) override
-    {
-        // Marks event parameter as unused
-        Q_UNUSED(event);
-
-        // Creates a painter object to draw on this widget
-        QPainter painter(this);
-        // For smooth edges:
-        painter.setRenderHint(QPainter::Antialiasing);
 
-        // If no grid data is available, draw empty green field
-        if (!m_grid || m_grid->isEmpty())
+        // Show the whole field again when its resolution changes
+        if (m_grid && (m_grid->width() != m_viewGridWidth || m_grid->height() != m_viewGridHeight))
         {
-            painter.fillRect(rect(), Qt::darkGreen);
-            return;
+            fitView();
         }
-
-        // Get grid dimensions based on current field size
-        int gridWidth = m_grid->size();
-        int gridHeight = (*m_grid)[0].size();
-        int fieldSizePx = fieldSizes[m_fieldSize];
-
-        // Draw grass fields
-        for (int x = 0; x < gridWidth; ++x)
-        {
-            // Get grass color based on growth level
-            // Higher growth = darker green
-            for (int y = 0; y < gridHeight; ++y)
-            {
-                double ratio = static_cast<double>((*m_grid)[x][y]) / maxGrowth;
-                int green = 100 + static_cast<int>(155 * ratio);
-                QColor color(0, green, 0);
-
-                // Draw the grass tile
-                painter.fillRect(x * fieldSizePx, y * fieldSizePx,
-                                 fieldSizePx, fieldSizePx, color);
-
-                // Draw dark green grid lines around the tile
-                painter.setPen(QColor(0, 80, 0));
-                painter.drawRect(x * fieldSizePx, y * fieldSizePx,
-                                 fieldSizePx, fieldSizePx);
-            }
-        }
-
-        // Draw herd as a brown rectangle
-        painter.fillRect(m_herdX * fieldSizePx, m_herdY * fieldSizePx,
-                         m_herdWidth * fieldSizePx, m_herdHeight * fieldSizePx,
-                         QColor(101, 67, 33));
-
-        // Draw white border around the herd
-        painter.setPen(Qt::white);
-        painter.drawRect(m_herdX * fieldSizePx, m_herdY * fieldSizePx,
-                         m_herdWidth * fieldSizePx, m_herdHeight * fieldSizePx);
+        update();                  // Schedule a repaint
     }
 
+protected:
+    void paintEvent(QPaintEvent* event) override;             // Draws the visible part of the field
+    void wheelEvent(QWheelEvent* event) override;             // Zooms around the mouse
+    void mousePressEvent(QMouseEvent* event) override;        // Starts panning
+    void mouseMoveEvent(QMouseEvent* event) override;         // Pans the view
+    void mouseReleaseEvent(QMouseEvent* event) override;      // Stops panning
+    void mouseDoubleClickEvent(QMouseEvent* event) override;  // Fits the whole field
+
 private:
     // Game grid from main class
-    const QVector<QVector<int>>* m_grid = nullptr;
+    const PastureGrid* m_grid = nullptr;
 
     // Display values for field and herd
-    int m_fieldSize = 0;                    // Field size/zoom level
     int m_herdX = 0, m_herdY = 0;           // Herd position
     int m_herdWidth = 1, m_herdHeight = 1;  // Herd size
 
+    // View values, independent of the field resolution
+    double m_scale = 1;                          // Pixels per cell
+    double m_viewX = 0, m_viewY = 0;             // Cell at the top-left corner of the widget
+    int m_viewGridWidth = 0, m_viewGridHeight = 0; // Grid size the view was fitted to
+    bool m_panning = false;                      // true while dragging the view
+    QPointF m_lastMousePos;                      // Mouse position during panning
+
+    // Mean growth of cell blocks for drawing zoomed out views
+    PastureMip m_mip;
+
+    // Draws the visible cells into one image on all cores
+    PastureRasterizer m_rasterizer;
+
+    // View functions
+    void fitView();                              // Shows the whole field
+    void clampView();                            // Keeps part of the field in view
+    int toPixelX(double cellX) const;            // Cell x coordinate to widget pixel
+    int toPixelY(double cellY) const;            // Cell y coordinate to widget pixel
 
-    // Constants from main class
-    static const QVector<int> fieldSizes;  // Available field sizes
-    static constexpr int maxGrowth = 15;   // Maximum grass growth level
+    // View limits
+    static constexpr double maxScale = 64; // Most pixels per cell when zoomed in
 };
 
 #endif // HERD_OF_GRAZING_COWS_H
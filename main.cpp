@@ -1,11 +1,50 @@
 #include "herd_of_grazing_cows.h"
+#include "headless_runner.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
 
 int main(int argc, char *argv[])
 {
+    // Command line exports run without a window
+    if (HeadlessRunner::isRequested(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+        return HeadlessRunner::run(a.arguments());
+    }
+
     QApplication a(argc, argv);
     Herd_of_Grazing_Cows w;
+
+    // Optional telemetry socket for dashboards and pasture file
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption telemetryOption("telemetry", "Stream the game to local socket <name>.", "name");
+    QCommandLineOption pastureOption("pasture", "Keep the field in memory-mapped <file>, loading the field saved in it.", "file");
+    parser.addOption(telemetryOption);
+    parser.addOption(pastureOption);
+    parser.process(a);
+    if (parser.isSet(telemetryOption))
+    {
+        QString errorMessage;
+        if (!w.startTelemetry(parser.value(telemetryOption), &errorMessage))
+        {
+            QTextStream(stderr) << errorMessage << "\n";
+            return 1;
+        }
+    }
+
+    if (parser.isSet(pastureOption))
+    {
+        QString errorMessage;
+        if (!w.usePastureFile(parser.value(pastureOption), &errorMessage))
+        {
+            QTextStream(stderr) << errorMessage << "\n";
+            return 1;
+        }
+    }
+
     w.show();
     return a.exec();
 }
@@ -0,0 +1,138 @@
+#include "pasture_file.h"
+#include <cstring>         // For memcmp and memcpy
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>      // For madvise
+#include <unistd.h>        // For the page size
+#endif
+
+
+// Destructor unmaps the file
+PastureFile::~PastureFile()
+{
+    if (mapping)
+    {
+        file.unmap(mapping);
+    }
+}
+
+// Maps the file, creating or growing it when needed
+// Nothing but the header is read here
+bool PastureFile::open(const QString& path, int maxCells, QString* errorMessage)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite))
+    {
+        *errorMessage = QString("Could not open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    // A new or short file is extended, the new space reads as zeros
+    qint64 size = headerSize + static_cast<qint64>(maxCells);
+    bool created = file.size() == 0;
+    if (file.size() < size && !file.resize(size))
+    {
+        *errorMessage = QString("Could not resize %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    mapping = file.map(0, size);
+    if (!mapping)
+    {
+        *errorMessage = QString("Could not map %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    mappedSize = size;
+    header = reinterpret_cast<Header*>(mapping);
+    mappedCells = mapping + headerSize;
+
+    // Check the header, a new file gets an empty field
+    if (created)
+    {
+        memcpy(header->magic, "PASTURE1", sizeof(header->magic));
+        header->width = 0;
+        header->height = 0;
+    }
+    else if (memcmp(header->magic, "PASTURE1", sizeof(header->magic)) != 0)
+    {
+        *errorMessage = QString("%1 is not a pasture file").arg(path);
+        file.unmap(mapping);
+        mapping = nullptr;
+        return false;
+    }
+
+#if defined(Q_OS_UNIX) && defined(MADV_SEQUENTIAL)
+    // The herd sweeps the columns in order, so read ahead and drop pages behind it
+    madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+// Reads just the header
+// A missing or empty file is a new pasture, open() will create it
+bool PastureFile::readSize(const QString& path, int* width, int* height, QString* errorMessage)
+{
+    *width = 0;
+    *height = 0;
+    QFile headerFile(path);
+    if (!headerFile.exists() || headerFile.size() == 0)
+    {
+        return true;
+    }
+    if (!headerFile.open(QIODevice::ReadOnly))
+    {
+        *errorMessage = QString("Could not open %1: %2").arg(path, headerFile.errorString());
+        return false;
+    }
+
+    Header saved;
+    if (headerFile.read(reinterpret_cast<char*>(&saved), sizeof(saved)) != sizeof(saved)
+        || memcmp(saved.magic, "PASTURE1", sizeof(saved.magic)) != 0)
+    {
+        *errorMessage = QString("%1 is not a pasture file").arg(path);
+        return false;
+    }
+    *width = saved.width;
+    *height = saved.height;
+    return true;
+}
+
+// Field size saved in the header
+int PastureFile::getWidth() const
+{
+    return header ? header->width : 0;
+}
+
+int PastureFile::getHeight() const
+{
+    return header ? header->height : 0;
+}
+
+void PastureFile::setSize(int width, int height)
+{
+    header->width = width;
+    header->height = height;
+}
+
+// Asks the system to start reading cells in
+void PastureFile::prefetch(qint64 firstCell, qint64 cellCount) const
+{
+#if defined(Q_OS_UNIX) && defined(MADV_WILLNEED)
+    if (!mapping || cellCount <= 0)
+    {
+        return;
+    }
+
+    // madvise needs a page aligned start
+    static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    qint64 start = headerSize + firstCell;
+    qint64 end = qMin(start + cellCount, mappedSize);
+    qint64 alignedStart = start - start % pageSize;
+    if (end > alignedStart)
+    {
+        madvise(mapping + alignedStart, end - alignedStart, MADV_WILLNEED);
+    }
+#else
+    Q_UNUSED(firstCell);
+    Q_UNUSED(cellCount);
+#endif
+}
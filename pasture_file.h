@@ -0,0 +1,53 @@
+#ifndef PASTURE_FILE_H
+#define PASTURE_FILE_H
+
+#include <QFile>            // Backing file
+#include <QString>          // Paths and errors
+
+// Pasture file class keeping the field cells in a memory-mapped file
+// Opening a file only maps it, cells are read by the system when they are
+// first used, so even a big pasture opens straight away and only the parts
+// in use take up memory.
+//
+// The first page is a header with the field size, the cells follow one byte
+// each, column by column, in the same layout PastureGrid uses in memory
+class PastureFile
+{
+public:
+    // deconstructor unmaps and closes the file, changes are already in it
+    ~PastureFile();
+
+    // Opens or creates a pasture file with room for maxCells cells
+    bool open(const QString& path, int maxCells, QString* errorMessage);
+
+    // Reads the field size saved in a file without mapping it, 0 x 0 if there is no file yet
+    static bool readSize(const QString& path, int* width, int* height, QString* errorMessage);
+
+    // Mapped cells, column by column
+    quint8* cells() const { return mappedCells; }
+
+    // Field size saved in the file, 0 x 0 for a new file
+    int getWidth() const;
+    int getHeight() const;
+    void setSize(int width, int height);
+
+    // Access hints, see madvise()
+    void prefetch(qint64 firstCell, qint64 cellCount) const;   // Cells that will be used soon
+
+private:
+    // File header, padded to one page so the cells start page aligned
+    struct Header {
+        char magic[8];      // "PASTURE1"
+        qint32 width;       // Field width in cells
+        qint32 height;      // Field height in cells
+    };
+    static const int headerSize = 4096;
+
+    QFile file;                     // Open pasture file
+    uchar* mapping = nullptr;       // Whole file mapped
+    Header* header = nullptr;       // Start of the mapping
+    quint8* mappedCells = nullptr;  // Cells after the header
+    qint64 mappedSize = 0;          // Bytes mapped
+};
+
+#endif // PASTURE_FILE_H
@@ -0,0 +1,191 @@
+#ifndef PASTURE_GRID_H
+#define PASTURE_GRID_H
+
+#include <QVector>          // Cell storage
+#include <QtGlobal>         // Qt types
+#include <QScopedPointer>   // Optional pasture file
+#include <cstring>          // For memcpy
+#include "pasture_file.h"   // Memory-mapped cells
+
+// Pasture grid class storing the grass growth level of every cell
+// Cells are stored column by column in one block, so the herd sweeping a
+// column reads memory in order and resizing reuses the same storage
+//
+// Changes are tracked per square tile of cells with a version number, so
+// views of the grid can update only the tiles that changed
+//
+// The cells can also live in a memory-mapped PastureFile instead of memory,
+// everything else works the same
+class PastureGrid
+{
+public:
+    static const int tileSize = 16;  // Cells per side of a change tracking tile
+
+    // Makes sure fields up to maxWidth x maxHeight never need new memory
+    void reserve(int maxWidth, int maxHeight)
+    {
+        ownedCells.reserve(maxWidth * maxHeight);
+        cells = ownedCells.data();
+        tileVersions.reserve(tilesFor(maxWidth) * tilesFor(maxHeight));
+    }
+
+    // Changes the grid size, keeping the storage when it is big enough
+    // Every view has to start over, so the generation changes
+    void resize(int width, int height)
+    {
+        gridWidth = width;
+        gridHeight = height;
+        if (file)
+        {
+            // The file has room for the largest field
+            file->setSize(width, height);
+        }
+        else
+        {
+            ownedCells.resize(width * height);
+            cells = ownedCells.data();
+        }
+        tileColumns = tilesFor(width);
+        tileRows = tilesFor(height);
+        tileVersions.fill(0, tileColumns * tileRows);
+        generation++;
+    }
+
+    // Grid dimensions in cells
+    int width() const { return gridWidth; }
+    int height() const { return gridHeight; }
+    bool isEmpty() const { return gridWidth == 0 || gridHeight == 0; }
+
+    // Growth level of one cell, (0,0) is the top-left corner
+    int at(int x, int y) const { return cells[x * gridHeight + y]; }
+    void set(int x, int y, int value)
+    {
+        cells[x * gridHeight + y] = static_cast<quint8>(value);
+        tileVersions[(x / tileSize) * tileRows + y / tileSize]++;
+    }
+
+    // All cells of one column, top to bottom
+    // Writing through column() must be followed by touch() or touchCell() for the changed cells
+    quint8* column(int x) { return cells + x * gridHeight; }
+    const quint8* column(int x) const { return cells + x * gridHeight; }
+
+    // Swaps all cells with another plane of the same size, for double buffered updates
+    // The caller marks the changed cells with touch()
+    // Mapped cells can't be swapped, so they are copied
+    void swapCells(QVector<quint8>& plane)
+    {
+        if (file)
+        {
+            memcpy(cells, plane.constData(), static_cast<size_t>(gridWidth) * gridHeight);
+        }
+        else
+        {
+            ownedCells.swap(plane);
+            cells = ownedCells.data();
+        }
+    }
+
+    // Moves the cells into a memory-mapped file with room for maxCells cells
+    // A field saved in the file is never written over: its cells and size
+    // replace the current ones and loaded is set to true. A new file gets the
+    // current cells
+    bool mapFile(const QString& path, int maxCells, bool* loaded, QString* errorMessage)
+    {
+        if (gridWidth * gridHeight > maxCells)
+        {
+            *errorMessage = "Field is larger than the pasture file";
+            return false;
+        }
+        QScopedPointer<PastureFile> newFile(new PastureFile);
+        if (!newFile->open(path, maxCells, errorMessage))
+        {
+            return false;
+        }
+
+        int savedWidth = newFile->getWidth();
+        int savedHeight = newFile->getHeight();
+        *loaded = savedWidth != 0 || savedHeight != 0;
+        if (*loaded)
+        {
+            if (savedWidth <= 0 || savedHeight <= 0 || static_cast<qint64>(savedWidth) * savedHeight > maxCells)
+            {
+                *errorMessage = QString("%1 holds a %2x%3 pasture, which doesn't fit in %4 cells")
+                                    .arg(path).arg(savedWidth).arg(savedHeight).arg(maxCells);
+                return false;
+            }
+        }
+        else
+        {
+            memcpy(newFile->cells(), cells, static_cast<size_t>(gridWidth) * gridHeight);
+            newFile->setSize(gridWidth, gridHeight);
+        }
+        file.reset(newFile.take());
+        cells = file->cells();
+
+        // Memory copy is not needed any more
+        ownedCells = QVector<quint8>();
+
+        // A saved field of another size takes over, resize() writes the same size back
+        if (*loaded && (savedWidth != gridWidth || savedHeight != gridHeight))
+        {
+            resize(savedWidth, savedHeight);
+        }
+        touch(0, 0, gridWidth, gridHeight);
+        return true;
+    }
+    bool isMapped() const { return !file.isNull(); }
+
+    // Tells a mapped file that some columns will be used soon, does nothing in memory
+    void prefetchColumns(int firstColumn, int columnCount) const
+    {
+        if (file && firstColumn < gridWidth)
+        {
+            columnCount = qMin(columnCount, gridWidth - firstColumn);
+            file->prefetch(static_cast<qint64>(firstColumn) * gridHeight,
+                           static_cast<qint64>(columnCount) * gridHeight);
+        }
+    }
+
+    // Marks one cell as changed
+    void touchCell(int x, int y)
+    {
+        tileVersions[(x / tileSize) * tileRows + y / tileSize]++;
+    }
+
+    // Marks a rectangle of cells as changed, right and bottom are one past the last cell
+    void touch(int left, int top, int right, int bottom)
+    {
+        if (right <= left || bottom <= top)
+            return;
+        for (int tileX = left / tileSize; tileX <= (right - 1) / tileSize; ++tileX)
+        {
+            for (int tileY = top / tileSize; tileY <= (bottom - 1) / tileSize; ++tileY)
+            {
+                tileVersions[tileX * tileRows + tileY]++;
+            }
+        }
+    }
+
+    // Change tracking
+    quint32 getGeneration() const { return generation; }    // Changes when the grid is resized
+    int getTileColumns() const { return tileColumns; }      // Tiles across the grid
+    int getTileRows() const { return tileRows; }            // Tiles down the grid
+    quint32 tileVersion(int tileX, int tileY) const { return tileVersions[tileX * tileRows + tileY]; }
+
+private:
+    // Number of tiles needed to cover a number of cells
+    static int tilesFor(int cellCount) { return (cellCount + tileSize - 1) / tileSize; }
+
+    quint8* cells = nullptr;        // Growth levels 0-15, column by column
+    QVector<quint8> ownedCells;     // Cell memory when there is no file
+    QScopedPointer<PastureFile> file; // Cell file, if the cells are mapped
+    int gridWidth = 0;              // Number of columns
+    int gridHeight = 0;             // Number of rows
+
+    QVector<quint32> tileVersions;  // Bumped whenever a cell in the tile changes
+    int tileColumns = 0;            // Tiles across
+    int tileRows = 0;               // Tiles down
+    quint32 generation = 0;         // Bumped on every resize
+};
+
+#endif // PASTURE_GRID_H
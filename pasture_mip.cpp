@@ -0,0 +1,110 @@
+#include "pasture_mip.h"
+#include "pasture_grid.h"
+
+
+// Updates the levels from the tiles that changed
+void PastureMip::update(const PastureGrid& grid)
+{
+    int tileColumns = grid.getTileColumns();
+    int tileRows = grid.getTileRows();
+
+    // A resized grid starts over with all levels
+    if (!built || grid.getGeneration() != seenGeneration)
+    {
+        gridWidth = grid.width();
+        gridHeight = grid.height();
+
+        // Levels go up until one block covers the whole field
+        int levels = 0;
+        while ((1 << levels) < qMax(gridWidth, gridHeight))
+        {
+            levels++;
+        }
+        sums.resize(levels);
+        for (int level = 1; level <= levels; ++level)
+        {
+            sums[level - 1].resize(levelWidth(level) * levelHeight(level));
+        }
+
+        seenTileVersions.resize(tileColumns * tileRows);
+        for (int tileX = 0; tileX < tileColumns; ++tileX)
+        {
+            for (int tileY = 0; tileY < tileRows; ++tileY)
+            {
+                seenTileVersions[tileX * tileRows + tileY] = grid.tileVersion(tileX, tileY);
+            }
+        }
+        seenGeneration = grid.getGeneration();
+        built = true;
+
+        updateRegion(grid, 0, 0, gridWidth, gridHeight);
+        return;
+    }
+
+    // Otherwise only recompute the blocks over changed tiles
+    for (int tileX = 0; tileX < tileColumns; ++tileX)
+    {
+        for (int tileY = 0; tileY < tileRows; ++tileY)
+        {
+            quint32 version = grid.tileVersion(tileX, tileY);
+            quint32& seen = seenTileVersions[tileX * tileRows + tileY];
+            if (version != seen)
+            {
+                seen = version;
+                int left = tileX * PastureGrid::tileSize;
+                int top = tileY * PastureGrid::tileSize;
+                updateRegion(grid, left, top,
+                             qMin(left + PastureGrid::tileSize, gridWidth),
+                             qMin(top + PastureGrid::tileSize, gridHeight));
+            }
+        }
+    }
+}
+
+// Recomputes blocks level by level, each from the four blocks below it
+void PastureMip::updateRegion(const PastureGrid& grid, int left, int top, int right, int bottom)
+{
+    for (int level = 1; level <= sums.size(); ++level)
+    {
+        int width = levelWidth(level);
+        int height = levelHeight(level);
+        int belowWidth = level == 1 ? gridWidth : levelWidth(level - 1);
+        int belowHeight = level == 1 ? gridHeight : levelHeight(level - 1);
+        QVector<quint32>& blocks = sums[level - 1];
+
+        // Blocks of this level that overlap the changed cells
+        int firstX = left >> level;
+        int lastX = qMin((right - 1) >> level, width - 1);
+        int firstY = top >> level;
+        int lastY = qMin((bottom - 1) >> level, height - 1);
+
+        for (int x = firstX; x <= lastX; ++x)
+        {
+            for (int y = firstY; y <= lastY; ++y)
+            {
+                // Add up the children that are inside the level below
+                quint32 sum = 0;
+                for (int childX = 2 * x; childX < qMin(2 * x + 2, belowWidth); ++childX)
+                {
+                    for (int childY = 2 * y; childY < qMin(2 * y + 2, belowHeight); ++childY)
+                    {
+                        sum += level == 1 ? static_cast<quint32>(grid.at(childX, childY))
+                                          : sums[level - 2][childX * belowHeight + childY];
+                    }
+                }
+                blocks[x * height + y] = sum;
+            }
+        }
+    }
+}
+
+// Mean growth of a block
+int PastureMip::mean(int level, int x, int y) const
+{
+    // Count the cells actually inside the field
+    int size = 1 << level;
+    int cellsAcross = qMin(size, gridWidth - x * size);
+    int cellsDown = qMin(size, gridHeight - y * size);
+    quint32 sum = sums[level - 1][x * levelHeight(level) + y];
+    return static_cast<int>(sum / static_cast<quint32>(cellsAcross * cellsDown));
+}
@@ -0,0 +1,41 @@
+#ifndef PASTURE_MIP_H
+#define PASTURE_MIP_H
+
+#include <QVector>          // Block storage
+#include <QtGlobal>         // Qt types
+
+class PastureGrid;
+
+// Pasture mip class keeping the mean growth of square blocks of cells
+// Level k has one block per 2^k x 2^k cells, so a zoomed out view can draw one
+// block per pixel instead of every cell. Only tiles of the grid that changed
+// since the last update are recomputed
+class PastureMip
+{
+public:
+    // Brings every level up to date with the grid
+    void update(const PastureGrid& grid);
+
+    // Number of levels above the cells, the last one is a single block
+    int levelCount() const { return sums.size(); }
+
+    // Blocks across and down a level, level 1 has blocks of 2x2 cells
+    int levelWidth(int level) const { return (gridWidth + (1 << level) - 1) >> level; }
+    int levelHeight(int level) const { return (gridHeight + (1 << level) - 1) >> level; }
+
+    // Mean growth level of one block, blocks at the field edge may hold fewer cells
+    int mean(int level, int x, int y) const;
+
+private:
+    QVector<QVector<quint32>> sums;   // Growth sums per block, column by column, index level - 1
+    QVector<quint32> seenTileVersions; // Grid tile versions the sums include
+    quint32 seenGeneration = 0;        // Grid generation the sums were built for
+    bool built = false;                // false until the first update
+    int gridWidth = 0;                 // Cells across
+    int gridHeight = 0;                // Cells down
+
+    // Recomputes every block covering a rectangle of cells, right and bottom are one past the last cell
+    void updateRegion(const PastureGrid& grid, int left, int top, int right, int bottom);
+};
+
+#endif // PASTURE_MIP_H
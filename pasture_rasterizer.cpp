@@ -0,0 +1,262 @@
+#include "pasture_rasterizer.h"
+#include "pasture_grid.h"
+#include "pasture_mip.h"
+#include "worker_pool.h"
+#include <QThread>         // For the core count
+#include <QColor>          // For the palette
+#include <algorithm>       // For std::fill
+#include <cmath>           // For floor
+#include <cstring>         // For memcpy
+#ifdef __SSE2__
+#include <emmintrin.h>     // For SSE2 vector instructions
+#endif
+
+
+// Converts a cell coordinate to a pixel, same rounding as the display widget
+static int toPixel(double cell, double viewCell, double scale)
+{
+    return static_cast<int>(std::floor((cell - viewCell) * scale));
+}
+
+
+// Rasterizer constructor
+// Colors are worked out once here, so drawing a frame only looks them up
+PastureRasterizer::PastureRasterizer(int threadCount)
+    : threadCount(qBound(1, threadCount > 0 ? threadCount : QThread::idealThreadCount(), 64))
+{
+    if (this->threadCount > 1)
+    {
+        pool.reset(new WorkerPool(this->threadCount));
+    }
+    bandJob = [this](int band) { fillBand(band); };
+
+    // Higher growth = darker green, same colors as before
+    for (int i = 0; i <= maxGrowth; ++i)
+    {
+        double ratio = static_cast<double>(i) / maxGrowth;
+        greens[i] = static_cast<quint8>(100 + static_cast<int>(155 * ratio));
+        palette[i] = qRgb(0, greens[i], 0);
+    }
+    backgroundColor = QColor(Qt::darkGreen).rgb();
+    lineColor = qRgb(0, 80, 0);
+}
+
+// Destructor, the pool joins its band workers when it is deleted
+PastureRasterizer::~PastureRasterizer()
+{
+}
+
+// Works out which block every pixel shows, then fills the bands
+const QImage& PastureRasterizer::render(const PastureGrid& grid, const PastureMip& mip,
+                                        const View& view, const QSize& size)
+{
+    // Every pixel is written, so an old image of the right size is reused as it is
+    // The colors are opaque, so premultiplied ARGB32 holds the same values and draws fastest
+    if (image.size() != size)
+    {
+        image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    }
+    if (image.isNull())
+    {
+        return image;
+    }
+    int width = image.width();
+    int height = image.height();
+
+    this->grid = &grid;
+    this->mip = &mip;
+    level = view.level;
+    int blockCells = 1 << level;
+    int blocksWide = level > 0 ? mip.levelWidth(level) : grid.width();
+    int blocksHigh = level > 0 ? mip.levelHeight(level) : grid.height();
+
+    // Blocks inside the image
+    firstBlockX = qMax(0, static_cast<int>(std::floor(view.x / blockCells)));
+    int lastX = qMin(blocksWide - 1, static_cast<int>(std::floor((view.x + width / view.scale) / blockCells)));
+    int firstY = qMax(0, static_cast<int>(std::floor(view.y / blockCells)));
+    int lastY = qMin(blocksHigh - 1, static_cast<int>(std::floor((view.y + height / view.scale) / blockCells)));
+    blockCount = qMax(0, lastX - firstBlockX + 1);
+
+    // Pixel columns of each visible block, blocks narrower than a pixel are left out
+    spans.resize(0);
+    for (int x = firstBlockX; x <= lastX; ++x)
+    {
+        int left = qMax(0, toPixel(x * blockCells, view.x, view.scale));
+        int right = qMin(width, toPixel((x + 1) * blockCells, view.x, view.scale));
+        if (right > left)
+        {
+            spans.append({left, right, x - firstBlockX});
+        }
+    }
+
+    // Block row under each pixel row
+    rowBlocks.fill(-1, height);
+    for (int y = firstY; y <= lastY; ++y)
+    {
+        int top = qMax(0, toPixel(y * blockCells, view.y, view.scale));
+        int bottom = qMin(height, toPixel((y + 1) * blockCells, view.y, view.scale));
+        for (int row = top; row < bottom; ++row)
+        {
+            rowBlocks[row] = y;
+        }
+    }
+
+    // Grid lines sit on the first pixel of every cell and one past the last cell
+    lineRows.fill(0, height);
+    lineColumns.resize(0);
+    fieldLeft = spans.isEmpty() ? 0 : spans.first().left;
+    fieldRight = spans.isEmpty() ? 0 : spans.last().right;
+    if (view.gridLines && !spans.isEmpty())
+    {
+        for (int x = firstBlockX; x <= lastX + 1; ++x)
+        {
+            int column = toPixel(x * blockCells, view.x, view.scale);
+            if (column >= 0 && column < width && (lineColumns.isEmpty() || lineColumns.last() != column))
+            {
+                lineColumns.append(column);
+            }
+        }
+        for (int y = firstY; y <= lastY + 1; ++y)
+        {
+            int row = toPixel(y * blockCells, view.y, view.scale);
+            if (row >= 0 && row < height)
+            {
+                lineRows[row] = 1;
+            }
+        }
+        if (!lineColumns.isEmpty() && lineColumns.last() == fieldRight)
+        {
+            fieldRight++;
+        }
+    }
+
+    // Bands share nothing but the tables above, each has its own row buffers
+    bandRows = qMax(minBandRows, (height + threadCount * bandsPerThread - 1) / (threadCount * bandsPerThread));
+    int bandCount = (height + bandRows - 1) / bandRows;
+    bandLevels.resize(bandCount * blockCount);
+    bandColors.resize(bandCount * blockCount);
+
+    // bits() may copy the image, so it is called once here and not in the bands
+    pixels = image.bits();
+    bytesPerLine = image.bytesPerLine();
+
+    if (pool)
+    {
+        pool->run(bandCount, bandJob);
+    }
+    else
+    {
+        for (int band = 0; band < bandCount; ++band)
+        {
+            fillBand(band);
+        }
+    }
+
+    this->grid = nullptr;
+    this->mip = nullptr;
+    return image;
+}
+
+// Fills every pixel row of one band
+void PastureRasterizer::fillBand(int band)
+{
+    int top = band * bandRows;
+    int bottom = qMin(top + bandRows, image.height());
+    quint8* levels = bandLevels.data() + band * blockCount;
+    QRgb* colors = bandColors.data() + band * blockCount;
+
+    for (int y = top; y < bottom; ++y)
+    {
+        QRgb* row = reinterpret_cast<QRgb*>(pixels + y * bytesPerLine);
+
+        // A row over the same blocks as the row above looks exactly the same
+        if (y > top && rowBlocks[y] == rowBlocks[y - 1] && lineRows[y] == lineRows[y - 1])
+        {
+            memcpy(row, pixels + (y - 1) * bytesPerLine, image.width() * sizeof(QRgb));
+        }
+        else if (lineRows[y])
+        {
+            fillEmptyRow(row, lineColor);
+        }
+        else if (rowBlocks[y] < 0)
+        {
+            fillEmptyRow(row, backgroundColor);
+        }
+        else
+        {
+            fillRow(row, rowBlocks[y], levels, colors);
+        }
+    }
+}
+
+// Looks up the blocks of a row and repeats their colors over their pixels
+void PastureRasterizer::fillRow(QRgb* row, int blockY, quint8* levels, QRgb* colors) const
+{
+    // Growth levels of the row, the grid is stored by column so this is one byte per column
+    for (int i = 0; i < blockCount; ++i)
+    {
+        int x = firstBlockX + i;
+        levels[i] = static_cast<quint8>(level > 0 ? mip->mean(level, x, blockY) : grid->column(x)[blockY]);
+    }
+    lookUpColors(levels, colors, blockCount);
+
+    int width = image.width();
+    int cellsRight = spans.isEmpty() ? fieldLeft : spans.last().right;
+    std::fill(row, row + fieldLeft, backgroundColor);
+    for (const Span& span : spans)
+    {
+        std::fill(row + span.left, row + span.right, colors[span.block]);
+    }
+    std::fill(row + cellsRight, row + width, backgroundColor);
+
+    for (int column : lineColumns)
+    {
+        row[column] = lineColor;
+    }
+}
+
+// A row with no cells, one color over the field and the background around it
+void PastureRasterizer::fillEmptyRow(QRgb* row, QRgb fieldColor) const
+{
+    int width = image.width();
+    std::fill(row, row + fieldLeft, backgroundColor);
+    std::fill(row + fieldLeft, row + fieldRight, fieldColor);
+    std::fill(row + fieldRight, row + width, backgroundColor);
+}
+
+// Turns growth levels into colors
+void PastureRasterizer::lookUpColors(const quint8* levels, QRgb* colors, int count) const
+{
+    int i = 0;
+#ifdef __SSE2__
+    // There is no byte shuffle in SSE2, so every level is compared and its green
+    // picked out, then the greens are spread into 0xFF00GG00 pixels
+    __m128i zero = _mm_setzero_si128();
+    __m128i alpha = _mm_set1_epi16(static_cast<short>(0xFF00));
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i levelVector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(levels + i));
+        __m128i green = zero;
+        for (int level = 0; level <= maxGrowth; ++level)
+        {
+            __m128i match = _mm_cmpeq_epi8(levelVector, _mm_set1_epi8(static_cast<char>(level)));
+            green = _mm_or_si128(green, _mm_and_si128(match, _mm_set1_epi8(static_cast<char>(greens[level]))));
+        }
+
+        // Pixel bytes in memory are blue, green, red, alpha
+        __m128i low = _mm_unpacklo_epi8(zero, green);
+        __m128i high = _mm_unpackhi_epi8(zero, green);
+        __m128i* out = reinterpret_cast<__m128i*>(colors + i);
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(low, alpha));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, alpha));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, alpha));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, alpha));
+    }
+#endif
+
+    // Levels left over, or every level without SSE2
+    for (; i < count; ++i)
+    {
+        colors[i] = palette[levels[i]];
+    }
+}
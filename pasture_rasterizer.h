@@ -0,0 +1,98 @@
+#ifndef PASTURE_RASTERIZER_H
+#define PASTURE_RASTERIZER_H
+
+#include <QtGlobal>         // Qt types and macros
+#include <QVector>          // Pixel to block tables
+#include <QImage>           // Frame image
+#include <QSize>            // Frame size
+#include <QScopedPointer>   // Optional worker pool
+#include <functional>       // For std::function
+
+class PastureGrid;
+class PastureMip;
+class WorkerPool;
+
+// Pasture rasterizer class drawing the visible field into one image per frame
+// The image is split into horizontal bands of pixel rows that are filled at
+// the same time on a worker pool. Each row looks up the growth level of the
+// blocks it crosses, turns them into colors 16 at a time with SSE2 where
+// available, and repeats each color over the pixels of its block. Rows of the
+// same blocks are copied from the row above, so big cells cost one row each.
+//
+// Pixels map to blocks exactly like GameDisplayWidget::toPixelX/Y, so the
+// herd drawn on top lines up with the cells
+class PastureRasterizer
+{
+public:
+    // What part of the field to draw and how
+    struct View {
+        double x = 0;           // Cell at the left edge of the image
+        double y = 0;           // Cell at the top edge of the image
+        double scale = 1;       // Pixels per cell
+        int level = 0;          // Mip level drawn, 0 draws the cells
+        bool gridLines = false; // Dark lines around every cell
+    };
+
+    // constructor that builds the palette and starts threadCount - 1 band workers
+    // 0 uses one thread per core
+    explicit PastureRasterizer(int threadCount = 0);
+
+    // deconstructor that joins the band workers
+    ~PastureRasterizer();
+
+    // Draws the field into an image of the given size and returns it
+    // The mip only has to be up to date when view.level is above 0
+    const QImage& render(const PastureGrid& grid, const PastureMip& mip, const View& view, const QSize& size);
+
+    // Threads filling bands, including the caller
+    int getThreadCount() const { return threadCount; }
+
+private:
+    Q_DISABLE_COPY(PastureRasterizer)
+
+    // Pixels covered by one block in a row
+    struct Span {
+        int left;       // First pixel
+        int right;      // One past the last pixel
+        int block;      // Block index from the first visible block
+    };
+
+    static constexpr int maxGrowth = 15;        // Highest growth level
+    static constexpr int minBandRows = 8;       // Fewer rows aren't worth a job
+    static constexpr int bandsPerThread = 4;    // Spare bands for threads that finish early
+
+    int threadCount;                    // Threads including the caller
+    QScopedPointer<WorkerPool> pool;    // Worker threads, only when threadCount > 1
+    std::function<void(int)> bandJob;   // Fills one band, made once so run() doesn't allocate
+
+    QRgb palette[maxGrowth + 1];        // Color of every growth level
+    quint8 greens[maxGrowth + 1];       // Green part of every color, for the vector lookup
+    QRgb backgroundColor;               // Outside the field
+    QRgb lineColor;                     // Grid lines
+
+    // Frame state, set by render() and read by the bands
+    QImage image;                       // Frame, reused while the size stays the same
+    const PastureGrid* grid = nullptr;  // Field being drawn
+    const PastureMip* mip = nullptr;    // Blocks for zoomed out views
+    int level = 0;                      // Mip level being drawn
+    int firstBlockX = 0;                // First visible block column
+    int blockCount = 0;                 // Visible block columns
+    int fieldLeft = 0;                  // First pixel column over the field
+    int fieldRight = 0;                 // One past the last pixel column over the field
+    uchar* pixels = nullptr;            // First pixel of the image
+    int bytesPerLine = 0;               // Distance between pixel rows
+    int bandRows = 0;                   // Pixel rows per band
+    QVector<Span> spans;                // Visible block columns from left to right
+    QVector<int> rowBlocks;             // Block row under every pixel row, -1 outside the field
+    QVector<quint8> lineRows;           // 1 for pixel rows on a grid line
+    QVector<int> lineColumns;           // Pixel columns on a grid line
+    QVector<quint8> bandLevels;         // Growth levels of one row, per band
+    QVector<QRgb> bandColors;           // Colors of one row, per band
+
+    void fillBand(int band);                                    // Fills the rows of one band
+    void fillRow(QRgb* row, int blockY, quint8* levels, QRgb* colors) const;  // Fills one row of cells
+    void fillEmptyRow(QRgb* row, QRgb fieldColor) const;        // Background with one color over the field
+    void lookUpColors(const quint8* levels, QRgb* colors, int count) const;   // Growth levels to colors
+};
+
+#endif // PASTURE_RASTERIZER_H
@@ -0,0 +1,313 @@
+#include "reference_game.h"
+#include "game_simulation.h"
+#include "scenario.h"
+#include <cmath>           // For fmod
+
+
+// Reference game constructor
+// Starts from the same values and random seed as a new GameSimulation
+ReferenceGame::ReferenceGame()
+    : random(1)
+{
+    upgrades = {
+        {"herdSpeed", 50, 2.0},
+        {"herdSize", 75, 1.3},
+        {"fieldSize", 150, 2.5},
+        {"growthRate", 10, 1.15},
+        {"dayRate", 5, 1.15},
+    };
+    generateField();
+}
+
+// Makes a new field, one random level per cell
+// Cells are drawn column by column like GameSimulation, so the same seed gives the same field
+void ReferenceGame::generateField()
+{
+    fieldWidth = GameSimulation::width / GameSimulation::fieldSizes[fieldSize];
+    fieldHeight = GameSimulation::height / GameSimulation::fieldSizes[fieldSize];
+    cells.fill(0, fieldWidth * fieldHeight);
+    for (int x = 0; x < fieldWidth; ++x)
+    {
+        for (int y = 0; y < fieldHeight; ++y)
+        {
+            cells[y * fieldWidth + x] = static_cast<quint8>(random.bounded(GameSimulation::maxGrowth));
+        }
+    }
+
+    // Spreading progress starts over on a new field
+    progress.fill(0, fieldWidth * fieldHeight);
+}
+
+// Uses time between days for super days
+void ReferenceGame::trackTime(qint64 currentTime)
+{
+    qint64 timeDifference = currentTime - lastDay;
+    lastDay = currentTime;
+
+    superExtra += timeDifference - dayRate;
+    if (superExtra > dayRate * 5)
+    {
+        superDays += static_cast<int>(superExtra / 5 / dayRate);
+        superExtra = fmod(superExtra, dayRate * 5);
+    }
+}
+
+// Makes every herd move of the day, one at a time
+void ReferenceGame::herdDay()
+{
+    for (int i = 0; i < herdSpeed; ++i)
+    {
+        moveHerdOnce();
+    }
+}
+
+// Clears the grown cells under the herd, then moves the herd one step
+void ReferenceGame::moveHerdOnce()
+{
+    for (int x = herdX; x < herdX + herdWidth; ++x)
+    {
+        for (int y = herdY; y < herdY + herdHeight; ++y)
+        {
+            // The herd can hang over the field after a field size upgrade
+            if (x >= fieldWidth || y >= fieldHeight || cells[y * fieldWidth + x] < 5)
+                continue;
+
+            cells[y * fieldWidth + x] = 0;
+            double value = 1.0 * (superDays > 0 ? 5 : 1);
+            money += value;
+            totalMoney += value;
+            totalCleared++;
+            if (superDays > 0)
+            {
+                superDays--;
+            }
+        }
+    }
+
+    // Down and up the columns, then back to the top left after the last column
+    int lastX = fieldWidth - herdWidth;
+    int lastY = fieldHeight - herdHeight;
+    if (herdDirectionUp ? herdY > 0 : herdY < lastY)
+    {
+        herdY += herdDirectionUp ? -1 : 1;
+    }
+    else if (herdX >= lastX)
+    {
+        herdDirectionUp = false;
+        herdX = 0;
+        herdY = 0;
+    }
+    else
+    {
+        herdX = qMin(herdX + herdWidth, lastX);
+        herdDirectionUp = !herdDirectionUp;
+    }
+}
+
+// Grows grass for one day in the current mode
+void ReferenceGame::growthDay()
+{
+    if (spreading)
+    {
+        spreadCells();
+    }
+    else
+    {
+        growRandomCells();
+    }
+}
+
+// Picks growthAmount random cells and grows each one level
+void ReferenceGame::growRandomCells()
+{
+    for (int i = 0; i < growthAmount; ++i)
+    {
+        int x = random.bounded(fieldWidth);
+        int y = random.bounded(fieldHeight);
+        quint8& cell = cells[y * fieldWidth + x];
+        if (cell < GameSimulation::maxGrowth)
+        {
+            cell++;
+        }
+    }
+}
+
+// Grows every cell from the mature neighbours it had at the start of the day
+void ReferenceGame::spreadCells()
+{
+    QVector<quint8> next = cells;
+    for (int y = 0; y < fieldHeight; ++y)
+    {
+        for (int x = 0; x < fieldWidth; ++x)
+        {
+            int matureNeighbours = 0;
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    // Corners only count with 8 neighbours, the cell itself never does
+                    if ((dx == 0 && dy == 0) || (dx != 0 && dy != 0 && spreadSettings.neighbours != 8))
+                        continue;
+                    int nx = x + dx;
+                    int ny = y + dy;
+                    if (nx >= 0 && nx < fieldWidth && ny >= 0 && ny < fieldHeight
+                        && cells[ny * fieldWidth + nx] >= SpreadingGrowth::matureLevel)
+                        matureNeighbours++;
+                }
+            }
+
+            // Every 16 progress is one level
+            int index = y * fieldWidth + x;
+            int total = progress[index] + spreadSettings.seedRate + spreadSettings.spreadRate * matureNeighbours;
+            progress[index] = static_cast<quint8>(total % 16);
+            next[index] = static_cast<quint8>(qMin(GameSimulation::maxGrowth, cells[index] + total / 16));
+        }
+    }
+    cells = next;
+}
+
+// Whether an upgrade can still be bought, same limits as GameSimulation
+bool ReferenceGame::canBuy(const QString& name) const
+{
+    if (name == "herdSpeed")
+        return herdSpeed < 50;
+    if (name == "herdSize")
+        return herdWidth < fieldHeight && herdHeight < fieldHeight;
+    if (name == "fieldSize")
+        return fieldSize < GameSimulation::fieldSizes.size() - 1;
+    if (name == "growthRate")
+        return growthAmount < 100;
+    if (name == "dayRate")
+        return dayRate > 1;
+    return false;
+}
+
+// Applies the effects of one upgrade level
+void ReferenceGame::applyUpgrade(const QString& name)
+{
+    if (name == "herdSpeed")
+    {
+        herdSpeed++;
+    }
+    else if (name == "herdSize")
+    {
+        // Width grows first, the herd starts its sweep over but keeps its direction
+        if (herdWidth == herdHeight)
+            herdWidth++;
+        else
+            herdHeight++;
+        herdX = 0;
+        herdY = 0;
+    }
+    else if (name == "fieldSize")
+    {
+        fieldSize++;
+        generateField();
+    }
+    else if (name == "growthRate")
+    {
+        growthAmount += 2;
+    }
+    else if (name == "dayRate")
+    {
+        dayRate = qMax(1, static_cast<int>(dayRate * 0.85));
+    }
+}
+
+// Buys an upgrade
+// The price goes up before it is paid, which is how the game has always charged
+bool ReferenceGame::buyUpgrade(const QString& name)
+{
+    for (Upgrade& upgrade : upgrades)
+    {
+        if (upgrade.name == name)
+        {
+            if (money < upgrade.price || !canBuy(name))
+                return false;
+            applyUpgrade(name);
+            upgrade.price *= upgrade.multiplier;
+            money = qMax(0.0, money - upgrade.price);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Restarts the game from a scenario, in the same steps as GameSimulation
+bool ReferenceGame::applyScenario(const Scenario& scenario, QString* errorMessage)
+{
+    if (scenario.fieldSize < 0 || scenario.fieldSize >= GameSimulation::fieldSizes.size())
+    {
+        *errorMessage = "fieldSize out of range";
+        return false;
+    }
+    fieldSize = scenario.fieldSize;
+    fieldWidth = GameSimulation::width / GameSimulation::fieldSizes[fieldSize];
+    fieldHeight = GameSimulation::height / GameSimulation::fieldSizes[fieldSize];
+
+    // Free upgrade levels
+    for (auto it = scenario.upgradeLevels.constBegin(); it != scenario.upgradeLevels.constEnd(); ++it)
+    {
+        Upgrade* upgrade = nullptr;
+        for (Upgrade& candidate : upgrades)
+        {
+            if (candidate.name == it.key())
+                upgrade = &candidate;
+        }
+        if (!upgrade)
+        {
+            *errorMessage = QString("Unknown upgrade %1").arg(it.key());
+            return false;
+        }
+        for (int i = 0; i < it.value() && canBuy(upgrade->name); ++i)
+        {
+            applyUpgrade(upgrade->name);
+            upgrade->price *= upgrade->multiplier;
+        }
+    }
+
+    // Explicit values
+    if (scenario.growthAmount >= 0)
+        growthAmount = scenario.growthAmount;
+    if (scenario.dayRate > 0)
+        dayRate = scenario.dayRate;
+    if (scenario.herdWidth > 0)
+        herdWidth = qMin(scenario.herdWidth, fieldWidth);
+    if (scenario.herdHeight > 0)
+        herdHeight = qMin(scenario.herdHeight, fieldHeight);
+    if (scenario.herdSpeed > 0)
+        herdSpeed = scenario.herdSpeed;
+
+    // Growth mode, threads don't matter here
+    spreading = scenario.growthMode == "spreading";
+    if (spreading)
+    {
+        const SpreadingGrowth::Settings& settings = scenario.spreadSettings;
+        if ((settings.neighbours != 4 && settings.neighbours != 8) || settings.seedRate < 0 || settings.seedRate > 16
+            || settings.spreadRate < 0 || settings.spreadRate > 16)
+        {
+            *errorMessage = "spread settings out of range";
+            return false;
+        }
+        spreadSettings = settings;
+    }
+    else if (!scenario.growthMode.isEmpty() && scenario.growthMode != "random")
+    {
+        *errorMessage = QString("Unknown growth mode %1").arg(scenario.growthMode);
+        return false;
+    }
+
+    // Fresh game state
+    money = scenario.money;
+    totalMoney = 0;
+    totalCleared = 0;
+    superExtra = 0;
+    superDays = 0;
+    herdX = 0;
+    herdY = 0;
+    herdDirectionUp = false;
+
+    random.seed(scenario.seed);
+    generateField();
+    return true;
+}
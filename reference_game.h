@@ -0,0 +1,100 @@
+#ifndef REFERENCE_GAME_H
+#define REFERENCE_GAME_H
+
+#include <QtGlobal>         // Qt types and macros
+#include <QVector>          // Field cells and upgrades
+#include <QString>          // Upgrade names and errors
+#include <QRandomGenerator> // Seeded random numbers for the field and growth
+#include "spreading_growth.h" // Spreading growth settings
+
+struct Scenario;
+
+// Reference game class with the original rules written out the plain way
+// It shares no code with GameSimulation: the field is one row-major vector,
+// the herd makes one move at a time, growth picks one cell at a time and
+// spreading looks at every neighbour of every cell. It is slow and only used
+// to check the fast game, see DifferentialFuzzer
+class ReferenceGame
+{
+public:
+    // constructor to create the same new game as GameSimulation
+    ReferenceGame();
+
+    // Game logic functions, same meaning as in GameSimulation
+    void trackTime(qint64 currentTime);         // Turns time lost between days into super days
+    void herdDay();                             // Makes the day's herd moves
+    void growthDay();                           // Grows grass for one day
+    bool buyUpgrade(const QString& name);       // Buys an upgrade if it is available and affordable
+    bool applyScenario(const Scenario& scenario, QString* errorMessage);  // Restarts the game from a scenario
+
+    // Growth mode, true for spreading growth
+    void setSpreading(bool on) { spreading = on; }
+    bool isSpreading() const { return spreading; }
+
+    // methods to get values for the game state
+    int gridWidth() const { return fieldWidth; }
+    int gridHeight() const { return fieldHeight; }
+    int at(int x, int y) const { return cells[y * fieldWidth + x]; }
+    double getMoney() const { return money; }
+    double getTotalMoney() const { return totalMoney; }
+    double getTotalCleared() const { return totalCleared; }
+    int getHerdX() const { return herdX; }
+    int getHerdY() const { return herdY; }
+    int getHerdWidth() const { return herdWidth; }
+    int getHerdHeight() const { return herdHeight; }
+    int getHerdSpeed() const { return herdSpeed; }
+    int getGrowthAmount() const { return growthAmount; }
+    int getFieldSize() const { return fieldSize; }
+    int getDayRate() const { return dayRate; }
+    int getSuperDays() const { return superDays; }
+    bool isHerdMovingUp() const { return herdDirectionUp; }
+
+private:
+    // Price of an upgrade, the effects are in canBuy() and applyUpgrade()
+    struct Upgrade {
+        QString name;       // Internal name, same as GameSimulation
+        double price;       // Current cost to purchase
+        double multiplier;  // Price increase multiplier after purchase
+    };
+
+    // money values
+    double money = 0;
+    double totalMoney = 0;
+    double totalCleared = 0;
+
+    // herd values
+    int herdX = 0, herdY = 0;
+    int herdWidth = 1, herdHeight = 1;
+    int herdSpeed = 1;
+    bool herdDirectionUp = false;
+
+    // field values
+    int growthAmount = 4;
+    int fieldSize = 0;
+    int dayRate = 1000;
+    int fieldWidth = 0;            // Field size in cells
+    int fieldHeight = 0;
+    QVector<quint8> cells;         // Growth level of every cell, one row after another
+
+    // time values
+    qint64 lastDay = 0;
+    double superExtra = 0;
+    int superDays = 0;
+
+    // Growth values
+    QRandomGenerator random;               // Same seeds and draws as GameSimulation
+    bool spreading = false;                // Spreading growth instead of random growth
+    SpreadingGrowth::Settings spreadSettings;
+    QVector<quint8> progress;              // Spreading progress of every cell, row-major like cells
+
+    QVector<Upgrade> upgrades;     // Same order as GameSimulation::getUpgrades()
+
+    void generateField();                          // Makes a new random field for the field size
+    void moveHerdOnce();                           // Clears the cells under the herd and moves it one step
+    void growRandomCells();                        // growthAmount random cells grow one level
+    void spreadCells();                            // Every cell grows from its neighbours
+    bool canBuy(const QString& name) const;        // Whether an upgrade still has levels left
+    void applyUpgrade(const QString& name);        // Upgrade effects
+};
+
+#endif // REFERENCE_GAME_H
@@ -0,0 +1,120 @@
+#include "scenario.h"
+#include <QFile>           // For reading JSON files
+#include <QFileInfo>       // For checking the file exists
+#include <QJsonDocument>   // For parsing JSON
+#include <QJsonObject>     // For JSON sections
+#include <QSettings>       // For parsing INI files
+#include <QVariantMap>     // For values by key
+
+
+// Loads scenario values from a file
+// Both formats use the same "group/key" names, for example "herd/speed"
+bool Scenario::load(const QString& path, QString* errorMessage)
+{
+    if (!QFileInfo::exists(path))
+    {
+        *errorMessage = QString("Scenario file %1 does not exist").arg(path);
+        return false;
+    }
+
+    // Collect every value as "group/key"
+    QVariantMap values;
+    if (path.endsWith(".json", Qt::CaseInsensitive))
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            *errorMessage = QString("Could not open %1").arg(path);
+            return false;
+        }
+
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+        if (!document.isObject())
+        {
+            *errorMessage = QString("%1: %2").arg(path, parseError.errorString());
+            return false;
+        }
+
+        // Each top level object is a group of values
+        // Anything else at the top is kept under its own name, so it is reported as unknown
+        QJsonObject root = document.object();
+        for (auto group = root.constBegin(); group != root.constEnd(); ++group)
+        {
+            if (!group.value().isObject())
+            {
+                values.insert(group.key(), group.value().toVariant());
+                continue;
+            }
+            QJsonObject section = group.value().toObject();
+            for (auto key = section.constBegin(); key != section.constEnd(); ++key)
+            {
+                values.insert(group.key() + "/" + key.key(), key.value().toVariant());
+            }
+        }
+    }
+    else
+    {
+        QSettings settings(path, QSettings::IniFormat);
+        if (settings.status() != QSettings::NoError)
+        {
+            *errorMessage = QString("Could not parse %1").arg(path);
+            return false;
+        }
+        for (const QString& key : settings.allKeys())
+        {
+            values.insert(key, settings.value(key));
+        }
+    }
+
+    // Read each value, unknown keys are reported so typos don't go unnoticed
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it)
+    {
+        const QString& key = it.key();
+        bool ok = true;
+
+        if (key == "field/fieldSize")
+            fieldSize = it.value().toInt(&ok);
+        else if (key == "field/growthAmount")
+            growthAmount = it.value().toInt(&ok);
+        else if (key == "field/dayRate")
+            dayRate = it.value().toInt(&ok);
+        else if (key == "herd/width")
+            herdWidth = it.value().toInt(&ok);
+        else if (key == "herd/height")
+            herdHeight = it.value().toInt(&ok);
+        else if (key == "herd/speed")
+            herdSpeed = it.value().toInt(&ok);
+        else if (key == "growth/mode")
+            growthMode = it.value().toString().toLower();
+        else if (key == "growth/neighbours")
+            spreadSettings.neighbours = it.value().toInt(&ok);
+        else if (key == "growth/seedRate")
+            spreadSettings.seedRate = it.value().toInt(&ok);
+        else if (key == "growth/spreadRate")
+            spreadSettings.spreadRate = it.value().toInt(&ok);
+        else if (key == "growth/threads")
+            spreadSettings.threads = it.value().toInt(&ok);
+        else if (key == "run/seed")
+            seed = it.value().toUInt(&ok);
+        else if (key == "run/days")
+            days = it.value().toInt(&ok);
+        else if (key == "run/money")
+            money = it.value().toDouble(&ok);
+        else if (key.startsWith("upgrades/"))
+            upgradeLevels.insert(key.mid(9), it.value().toInt(&ok));
+        else
+        {
+            *errorMessage = QString("%1: unknown key %2").arg(path, key);
+            return false;
+        }
+
+        if (!ok)
+        {
+            *errorMessage = QString("%1: %2 is not a number").arg(path, key);
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <QMap>             // Upgrade levels by name
+#include <QString>          // File paths and errors
+#include "spreading_growth.h" // Spreading growth settings
+
+// Scenario structure describing a starting game state
+// Loaded from an INI or JSON file for headless runs
+struct Scenario {
+    // field values
+    int fieldSize = 0;        // Zoom level for GameSimulation::fieldSizes
+    int growthAmount = -1;    // Growth per day, -1 keeps the value from the upgrades
+    int dayRate = -1;         // Milliseconds between days, -1 keeps the value from the upgrades
+
+    // herd values, -1 keeps the value from the upgrades
+    int herdWidth = -1;       // Herd width in cells
+    int herdHeight = -1;      // Herd height in cells
+    int herdSpeed = -1;       // Moves per day, not limited by the upgrade cap
+
+    // growth values
+    QString growthMode;                       // "random" (default) or "spreading"
+    SpreadingGrowth::Settings spreadSettings; // Used in spreading mode
+
+    // Upgrade levels bought for free before the run, by internal upgrade name
+    QMap<QString, int> upgradeLevels;
+
+    // run values
+    quint32 seed = 1;         // Random seed for the field and growth
+    int days = 1000;          // Number of days to simulate
+    double money = 0;         // Starting money
+
+    // Loads a scenario from an .ini or .json file
+    // Returns false and fills errorMessage if the file can't be used
+    bool load(const QString& path, QString* errorMessage);
+};
+
+#endif // SCENARIO_H
@@ -0,0 +1,259 @@
+#include "spreading_growth.h"
+#include "pasture_grid.h"
+#include "worker_pool.h"
+#include <cstring>         // For memset
+#ifdef __SSE2__
+#include <emmintrin.h>     // For SSE2 vector instructions
+#endif
+
+
+// Growth constructor
+SpreadingGrowth::SpreadingGrowth()
+{
+    blockJob = [this](int block) { growBlock(block); };
+}
+
+// Destructor, stops the worker pool if there is one
+SpreadingGrowth::~SpreadingGrowth()
+{
+}
+
+// Reserves the planes for the largest field
+// Sizes match prepare(), so the first day on any field doesn't allocate
+void SpreadingGrowth::reserve(int maxWidth, int maxHeight)
+{
+    int maxCells = maxWidth * maxHeight;
+    int maxTileColumns = (maxWidth + PastureGrid::tileSize - 1) / PastureGrid::tileSize;
+    int maxTileRows = (maxHeight + PastureGrid::tileSize - 1) / PastureGrid::tileSize;
+    nextCells.reserve(maxCells);
+    progress.reserve(maxCells);
+    tileChanged.reserve(maxTileColumns * maxTileRows);
+    scratch.reserve(maxTileColumns * 3 * (maxHeight + 2 + 16));
+}
+
+// Checks and applies new settings
+bool SpreadingGrowth::setSettings(const Settings& newSettings, QString* errorMessage)
+{
+    if (newSettings.neighbours != 4 && newSettings.neighbours != 8)
+    {
+        *errorMessage = "neighbours must be 4 or 8";
+        return false;
+    }
+    // 8 neighbours at 16 each plus the seed and leftover progress still fit in a byte
+    if (newSettings.seedRate < 0 || newSettings.seedRate > 16
+        || newSettings.spreadRate < 0 || newSettings.spreadRate > 16)
+    {
+        *errorMessage = "seedRate and spreadRate must be between 0 and 16";
+        return false;
+    }
+    if (newSettings.threads < 1 || newSettings.threads > 64)
+    {
+        *errorMessage = "threads must be between 1 and 64";
+        return false;
+    }
+
+    // Threads are started here, not when growing
+    if (newSettings.threads != settings.threads || (newSettings.threads > 1 && !pool))
+    {
+        pool.reset(newSettings.threads > 1 ? new WorkerPool(newSettings.threads) : nullptr);
+    }
+    settings = newSettings;
+    return true;
+}
+
+// Sizes the planes when the field changes
+// Progress starts over on a new field
+void SpreadingGrowth::prepare(const PastureGrid& grid)
+{
+    if (sized && grid.getGeneration() == seenGeneration)
+    {
+        return;
+    }
+
+    int cellCount = grid.width() * grid.height();
+    nextCells.resize(cellCount);
+    progress.fill(0, cellCount);
+    tileChanged.fill(0, grid.getTileColumns() * grid.getTileRows());
+
+    // A scratch column has one empty row above and below the field, plus room
+    // for a full vector read past the last row
+    scratchStride = grid.height() + 2 + 16;
+    scratch.fill(0, grid.getTileColumns() * 3 * scratchStride);
+
+    seenGeneration = grid.getGeneration();
+    sized = true;
+}
+
+// Grows every cell once
+void SpreadingGrowth::day(PastureGrid& grid)
+{
+    if (grid.isEmpty())
+    {
+        return;
+    }
+    prepare(grid);
+
+    // Each block is one tile column, so blocks never share tiles or cells they write
+    source = &grid;
+    if (pool)
+    {
+        pool->run(grid.getTileColumns(), blockJob);
+    }
+    else
+    {
+        for (int block = 0; block < grid.getTileColumns(); ++block)
+        {
+            growBlock(block);
+        }
+    }
+    source = nullptr;
+
+    // Swap in the new levels and let views know which tiles changed
+    grid.swapCells(nextCells);
+    for (int tileX = 0; tileX < grid.getTileColumns(); ++tileX)
+    {
+        for (int tileY = 0; tileY < grid.getTileRows(); ++tileY)
+        {
+            quint8& changed = tileChanged[tileX * grid.getTileRows() + tileY];
+            if (changed)
+            {
+                int left = tileX * PastureGrid::tileSize;
+                int top = tileY * PastureGrid::tileSize;
+                grid.touch(left, top, left + PastureGrid::tileSize, top + PastureGrid::tileSize);
+                changed = 0;
+            }
+        }
+    }
+}
+
+// Grows the columns of one tile column
+// Three scratch columns hold the spread amounts left of, at and right of the column being grown
+void SpreadingGrowth::growBlock(int block)
+{
+    int left = block * PastureGrid::tileSize;
+    int right = qMin(left + PastureGrid::tileSize, source->width());
+
+    quint8* previous = scratch.data() + block * 3 * scratchStride;
+    quint8* current = previous + scratchStride;
+    quint8* next = current + scratchStride;
+    fillMature(left - 1, previous);
+    fillMature(left, current);
+
+    for (int x = left; x < right; ++x)
+    {
+        fillMature(x + 1, next);
+        growColumn(x, previous, current, next);
+
+        // Shift the scratch columns one to the left
+        quint8* oldest = previous;
+        previous = current;
+        current = next;
+        next = oldest;
+    }
+}
+
+// Writes how much each cell of a column spreads to its neighbours
+// column[y + 1] is for row y, the rows above and below the field spread nothing
+void SpreadingGrowth::fillMature(int x, quint8* column) const
+{
+    int height = source->height();
+    if (x < 0 || x >= source->width())
+    {
+        memset(column, 0, height + 2);
+        return;
+    }
+
+    const quint8* cells = source->column(x);
+    quint8 spread = static_cast<quint8>(settings.spreadRate);
+    column[0] = 0;
+    column[height + 1] = 0;
+
+    int y = 0;
+#ifdef __SSE2__
+    __m128i below = _mm_set1_epi8(matureLevel - 1);
+    __m128i amount = _mm_set1_epi8(static_cast<char>(spread));
+    for (; y + 16 <= height; y += 16)
+    {
+        // Levels are at most 15, so the signed compare is safe
+        __m128i levels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + y));
+        __m128i mature = _mm_cmpgt_epi8(levels, below);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(column + y + 1), _mm_and_si128(mature, amount));
+    }
+#endif
+    for (; y < height; ++y)
+    {
+        column[y + 1] = cells[y] >= matureLevel ? spread : 0;
+    }
+}
+
+// Grows one column from its own progress and its neighbours
+void SpreadingGrowth::growColumn(int x, const quint8* left, const quint8* middle, const quint8* right)
+{
+    int height = source->height();
+    int tileRows = source->getTileRows();
+    const quint8* cells = source->column(x);
+    quint8* out = nextCells.data() + x * height;
+    quint8* cellProgress = progress.data() + x * height;
+    quint8* changed = tileChanged.data() + (x / PastureGrid::tileSize) * tileRows;
+    bool corners = settings.neighbours == 8;
+
+    int y = 0;
+#ifdef __SSE2__
+    // 16 rows at a time, which is exactly one tile row
+    __m128i seed = _mm_set1_epi8(static_cast<char>(settings.seedRate));
+    __m128i lowNibble = _mm_set1_epi8(0x0F);
+    __m128i top = _mm_set1_epi8(maxGrowth);
+    for (; y + 16 <= height; y += 16)
+    {
+        // Sum of the spread amounts around each cell, at most 8 * 16
+        __m128i sum = _mm_add_epi8(
+            _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(middle + y)),        // Above
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(middle + y + 2))),   // Below
+            _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + y + 1)),      // Left
+                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + y + 1))));   // Right
+        if (corners)
+        {
+            sum = _mm_add_epi8(sum, _mm_add_epi8(
+                _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + y)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + y + 2))),
+                _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(right + y)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + y + 2)))));
+        }
+
+        // New progress is at most 15 + 16 + 128, so bytes don't overflow
+        __m128i total = _mm_add_epi8(_mm_add_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(cellProgress + y)), seed), sum);
+        __m128i levels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + y));
+
+        // Whole levels gained, there is no byte shift so shift words and mask
+        __m128i gained = _mm_and_si128(_mm_srli_epi16(total, 4), lowNibble);
+        __m128i grown = _mm_min_epu8(_mm_add_epi8(levels, gained), top);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cellProgress + y), _mm_and_si128(total, lowNibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + y), grown);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(grown, levels)) != 0xFFFF)
+        {
+            changed[y / PastureGrid::tileSize] = 1;
+        }
+    }
+#endif
+
+    // Rows left over, or every row without SSE2
+    for (; y < height; ++y)
+    {
+        int sum = middle[y] + middle[y + 2] + left[y + 1] + right[y + 1];
+        if (corners)
+        {
+            sum += left[y] + left[y + 2] + right[y] + right[y + 2];
+        }
+        int total = cellProgress[y] + settings.seedRate + sum;
+        int grown = qMin(maxGrowth, cells[y] + (total >> 4));
+
+        cellProgress[y] = static_cast<quint8>(total & 0x0F);
+        out[y] = static_cast<quint8>(grown);
+        if (grown != cells[y])
+        {
+            changed[y / PastureGrid::tileSize] = 1;
+        }
+    }
+}
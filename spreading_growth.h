@@ -0,0 +1,75 @@
+#ifndef SPREADING_GROWTH_H
+#define SPREADING_GROWTH_H
+
+#include <QtGlobal>         // Qt types and macros
+#include <QVector>          // Cell planes
+#include <QScopedPointer>   // Optional worker pool
+#include <QString>          // Error messages
+#include <functional>       // For std::function
+
+class PastureGrid;
+class WorkerPool;
+
+// Spreading growth class where grass grows from mature neighbours
+// Every cell collects progress each day, a little on its own and more for each
+// mature neighbour (level 5 or more, the level the herd eats). 16 progress
+// makes one growth level, so rates are in sixteenths of a level per day.
+//
+// A day reads the field and writes a second plane that is swapped in at the
+// end, so every cell sees its neighbours as they were at the start of the day.
+// The field is worked on in blocks of one tile column, using SSE2 where
+// available, and the blocks can be spread over several threads.
+class SpreadingGrowth
+{
+public:
+    // Growth settings
+    struct Settings {
+        int neighbours = 4;   // 4 (sides) or 8 (sides and corners)
+        int seedRate = 1;     // Progress every cell gets per day, 0-16
+        int spreadRate = 4;   // Progress per mature neighbour per day, 0-16
+        int threads = 1;      // Threads working on a day
+    };
+
+    // constructor and deconstructor, the pool type is only known in the .cpp file
+    SpreadingGrowth();
+    ~SpreadingGrowth();
+
+    // Cell level the herd eats, which is also the level that spreads
+    static constexpr int matureLevel = 5;
+    static constexpr int maxGrowth = 15;   // Highest level, same as GameSimulation::maxGrowth
+
+    // Makes sure fields up to maxWidth x maxHeight never need new memory
+    void reserve(int maxWidth, int maxHeight);
+
+    // Changes the settings, returns false and fills errorMessage if they are out of range
+    bool setSettings(const Settings& settings, QString* errorMessage);
+    const Settings& getSettings() const { return settings; }
+
+    // Grows the whole field by one day
+    void day(PastureGrid& grid);
+
+private:
+    Q_DISABLE_COPY(SpreadingGrowth)
+
+    Settings settings;                  // Current settings
+    QScopedPointer<WorkerPool> pool;    // Worker threads, only when threads > 1
+
+    QVector<quint8> nextCells;       // Plane the day writes, swapped with the grid at the end
+    QVector<quint8> progress;        // Progress towards the next level per cell, 0-15
+    QVector<quint8> scratch;         // Mature neighbour columns, three per block
+    QVector<quint8> tileChanged;     // Tiles where a level changed this day
+    int scratchStride = 0;           // Bytes per scratch column
+    quint32 seenGeneration = 0;      // Grid generation the planes are sized for
+    bool sized = false;              // false until the planes are sized
+
+    // Grid of the day in progress, used by the block jobs
+    const PastureGrid* source = nullptr;
+    std::function<void(int)> blockJob;  // Calls growBlock, made once so days don't allocate
+
+    void prepare(const PastureGrid& grid);                    // Sizes the planes for the grid
+    void growBlock(int block);                                // Grows one tile column
+    void fillMature(int x, quint8* column) const;             // Spread amount per cell of a column
+    void growColumn(int x, const quint8* left, const quint8* middle, const quint8* right);
+};
+
+#endif // SPREADING_GROWTH_H
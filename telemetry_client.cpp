@@ -0,0 +1,243 @@
+#include "telemetry_client.h"
+#include "telemetry_server.h"
+#include <QLocalSocket>    // For connecting to the server
+#include <QTextStream>     // For printing messages
+#include <QtEndian>        // For little endian numbers
+#include <cstring>         // For memcpy
+
+
+// Reads a little endian number, returns false past the end of the message
+template <typename T>
+static bool readValue(const QByteArray& buffer, int& offset, int end, T* value)
+{
+    if (offset + static_cast<int>(sizeof(T)) > end)
+    {
+        return false;
+    }
+    *value = qFromLittleEndian<T>(reinterpret_cast<const uchar*>(buffer.constData() + offset));
+    offset += sizeof(T);
+    return true;
+}
+
+
+// Connects and reads until the server goes away
+int TelemetryClient::run(const QString& name, QTextStream& out)
+{
+    QLocalSocket socket;
+    socket.connectToServer(name, QIODevice::ReadOnly);
+    if (!socket.waitForConnected(5000))
+    {
+        out << "Could not connect to " << name << ": " << socket.errorString() << "\n";
+        return 1;
+    }
+
+    QByteArray buffer;
+    bool malformed = false;
+    bool connected = true;
+    while (connected && !malformed)
+    {
+        // After a disconnect the last bytes may still be waiting in the socket
+        if (socket.bytesAvailable() == 0)
+        {
+            connected = socket.waitForReadyRead(-1);
+        }
+        QByteArray received = socket.readAll();
+        bytesRead += received.size();
+        buffer.append(received);
+
+        // Decode every complete message
+        int offset = 0;
+        quint32 length = 0;
+        while (readValue(buffer, offset, buffer.size(), &length))
+        {
+            if (offset + static_cast<qint64>(length) > buffer.size())
+            {
+                offset -= sizeof(length);  // Rest of the message hasn't arrived
+                break;
+            }
+            if (!readMessage(buffer, offset, length, out))
+            {
+                out << "Malformed message after tick " << tick << "\n";
+                malformed = true;
+                break;
+            }
+            offset += length;
+        }
+        buffer.remove(0, offset);
+    }
+
+    out << "Snapshots:      " << snapshots << "\n";
+    out << "Deltas:         " << deltas << "\n";
+    out << "Coalesced:      " << missedTicks << "\n";
+    out << "Bytes read:     " << bytesRead << "\n";
+    out << "Mismatches:     " << mismatches << "\n";
+    out.flush();
+    return malformed || mismatches > 0 ? 3 : 0;
+}
+
+// Applies one message to the copy of the field and prints it
+bool TelemetryClient::readMessage(const QByteArray& buffer, int offset, int length, QTextStream& out)
+{
+    int end = offset + length;
+    quint32 previousTick = tick;
+    quint8 type = 0;
+    if (!readValue(buffer, offset, end, &type))
+    {
+        return false;
+    }
+
+    int tiles = 0;
+    if (type == TelemetryServer::Snapshot)
+    {
+        quint16 width = 0, height = 0;
+        quint8 upgradeCount = 0;
+        if (!readValue(buffer, offset, end, &width) || !readValue(buffer, offset, end, &height)
+            || !readValue(buffer, offset, end, &upgradeCount))
+        {
+            return false;
+        }
+
+        upgradeNames.clear();
+        for (int i = 0; i < upgradeCount; ++i)
+        {
+            quint8 nameLength = 0;
+            if (!readValue(buffer, offset, end, &nameLength) || offset + nameLength > end)
+            {
+                return false;
+            }
+            upgradeNames.append(QString::fromUtf8(buffer.constData() + offset, nameLength));
+            offset += nameLength;
+        }
+        upgradeLevels.resize(upgradeCount);
+
+        grid.resize(width, height);
+        if (!readState(buffer, offset, end) || !readCells(buffer, offset, end, 0, 0, width, height))
+        {
+            return false;
+        }
+        snapshots++;
+    }
+    else if (type == TelemetryServer::Delta)
+    {
+        quint16 tileCount = 0;
+        if (snapshots == 0 || !readState(buffer, offset, end) || !readValue(buffer, offset, end, &tileCount))
+        {
+            return false;
+        }
+        for (tiles = 0; tiles < tileCount; ++tiles)
+        {
+            quint16 tileX = 0, tileY = 0;
+            if (!readValue(buffer, offset, end, &tileX) || !readValue(buffer, offset, end, &tileY))
+            {
+                return false;
+            }
+            int left = tileX * PastureGrid::tileSize;
+            int top = tileY * PastureGrid::tileSize;
+            if (left >= grid.width() || top >= grid.height()
+                || !readCells(buffer, offset, end, left, top,
+                              qMin(left + PastureGrid::tileSize, grid.width()),
+                              qMin(top + PastureGrid::tileSize, grid.height())))
+            {
+                return false;
+            }
+        }
+        deltas++;
+        if (tick > previousTick + 1)
+        {
+            missedTicks += tick - previousTick - 1;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    // Leftover bytes mean the message was not understood
+    if (offset != end)
+    {
+        return false;
+    }
+
+    bool matches = TelemetryServer::checksum(grid) == sentChecksum;
+    if (!matches)
+    {
+        mismatches++;
+    }
+
+    // One line per message
+    out << "tick " << tick << ": " << (type == TelemetryServer::Snapshot ? "snapshot" : "delta")
+        << " " << length << " bytes";
+    if (type == TelemetryServer::Snapshot)
+    {
+        out << ", field " << grid.width() << "x" << grid.height();
+    }
+    else
+    {
+        out << ", " << tiles << " tiles";
+    }
+    out << ", herd " << herdWidth << "x" << herdHeight << " at (" << herdX << ", " << herdY << ")"
+        << ", money " << QString::number(money, 'f', 2) << ", super days " << superDays;
+    for (int i = 0; i < upgradeNames.size(); ++i)
+    {
+        out << ", " << upgradeNames[i] << " " << upgradeLevels[i];
+    }
+    out << (matches ? "" : ", CHECKSUM MISMATCH") << "\n";
+    return true;
+}
+
+// Reads the state block shared by both message types
+bool TelemetryClient::readState(const QByteArray& buffer, int& offset, int end)
+{
+    qint16 x = 0, y = 0, width = 0, height = 0;
+    quint64 moneyBits = 0;
+    qint32 days = 0;
+    if (!readValue(buffer, offset, end, &tick)
+        || !readValue(buffer, offset, end, &x) || !readValue(buffer, offset, end, &y)
+        || !readValue(buffer, offset, end, &width) || !readValue(buffer, offset, end, &height)
+        || !readValue(buffer, offset, end, &moneyBits) || !readValue(buffer, offset, end, &days))
+    {
+        return false;
+    }
+    for (int i = 0; i < upgradeLevels.size(); ++i)
+    {
+        quint16 level = 0;
+        if (!readValue(buffer, offset, end, &level))
+        {
+            return false;
+        }
+        upgradeLevels[i] = level;
+    }
+
+    herdX = x;
+    herdY = y;
+    herdWidth = width;
+    herdHeight = height;
+    memcpy(&money, &moneyBits, sizeof(money));
+    superDays = days;
+    return readValue(buffer, offset, end, &sentChecksum);
+}
+
+// Unpacks a rectangle of cells, two per byte, into the copy of the field
+bool TelemetryClient::readCells(const QByteArray& buffer, int& offset, int end, int left, int top, int right, int bottom)
+{
+    int cellCount = (right - left) * (bottom - top);
+    int byteCount = (cellCount + 1) / 2;
+    if (offset + byteCount > end)
+    {
+        return false;
+    }
+
+    const quint8* bytes = reinterpret_cast<const quint8*>(buffer.constData() + offset);
+    int index = 0;
+    for (int x = left; x < right; ++x)
+    {
+        for (int y = top; y < bottom; ++y)
+        {
+            quint8 packed = bytes[index / 2];
+            grid.set(x, y, index % 2 == 0 ? packed & 0x0F : packed >> 4);
+            index++;
+        }
+    }
+    offset += byteCount;
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef TELEMETRY_CLIENT_H
+#define TELEMETRY_CLIENT_H
+
+#include <QString>          // Server name
+#include <QStringList>      // Upgrade names
+#include <QVector>          // Upgrade levels
+#include <QByteArray>       // Received bytes
+#include "pasture_grid.h"   // Copy of the field
+
+class QTextStream;
+
+// Stand-in telemetry client for checking TelemetryServer from the command line
+// It keeps its own copy of the field from the snapshot and deltas, prints one
+// line per message and compares the field checksum the server sent
+class TelemetryClient
+{
+public:
+    // Reads messages until the server disconnects
+    // Returns 0 if every checksum matched, 3 if not, 1 if the server could not be reached
+    int run(const QString& name, QTextStream& out);
+
+private:
+    // Copy of the game state
+    PastureGrid grid;            // Field built from the messages
+    QStringList upgradeNames;    // Upgrade names from the snapshot
+    QVector<int> upgradeLevels;  // Levels by snapshot position
+    quint32 tick = 0;            // Tick of the last message
+    int herdX = 0, herdY = 0;    // Herd position
+    int herdWidth = 0, herdHeight = 0;  // Herd size
+    double money = 0;            // Money
+    int superDays = 0;           // Bonus days
+    quint32 sentChecksum = 0;    // Checksum the server sent with the last message
+
+    // Statistics
+    int snapshots = 0;           // Snapshot messages read
+    int deltas = 0;              // Delta messages read
+    int missedTicks = 0;         // Ticks the server coalesced into later deltas
+    int mismatches = 0;          // Messages whose checksum did not match
+    qint64 bytesRead = 0;        // Total bytes received
+
+    // Decoding functions, each returns false for a malformed message
+    bool readMessage(const QByteArray& buffer, int offset, int length, QTextStream& out);
+    bool readState(const QByteArray& buffer, int& offset, int end);
+    bool readCells(const QByteArray& buffer, int& offset, int end, int left, int top, int right, int bottom);
+};
+
+#endif // TELEMETRY_CLIENT_H
@@ -0,0 +1,358 @@
+#include "telemetry_server.h"
+#include "game_simulation.h"
+#include <QLocalServer>    // For accepting connections
+#include <QLocalSocket>    // For writing to clients
+#include <QElapsedTimer>   // For the finish timeout
+#include <QtEndian>        // For little endian numbers
+#include <cstring>         // For memcpy
+
+
+// Appends a number to a message in little endian order
+template <typename T>
+static void appendValue(QByteArray& message, T value)
+{
+    T littleEndian = qToLittleEndian(value);
+    message.append(reinterpret_cast<const char*>(&littleEndian), sizeof(T));
+}
+
+// Doubles are sent as their IEEE 754 bits
+static void appendDouble(QByteArray& message, double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    appendValue(message, bits);
+}
+
+
+// Server constructor
+TelemetryServer::TelemetryServer(QObject* parent)
+    : QObject(parent), server(new QLocalServer(this)), tick(0), publishing(false),
+    messagesSent(0), bytesSent(0), updatesSkipped(0)
+{
+    // Room for a snapshot of the finest field, so messages don't grow per tick
+    message.reserve(64 + GameSimulation::width * GameSimulation::height / 2);
+    connect(server, &QLocalServer::newConnection, this, &TelemetryServer::acceptClients);
+}
+
+// Destructor closes every connection
+TelemetryServer::~TelemetryServer()
+{
+    for (Client& client : clients)
+    {
+        client.socket->disconnect(this);
+        client.socket->abort();
+    }
+}
+
+// Starts the local socket server
+bool TelemetryServer::listen(const QString& name, QString* errorMessage)
+{
+    // A socket file left by a crashed run would make listen fail
+    QLocalServer::removeServer(name);
+    if (!server->listen(name))
+    {
+        *errorMessage = QString("Could not listen on %1: %2").arg(name, server->errorString());
+        return false;
+    }
+    return true;
+}
+
+// Blocks until a client connects or msecs pass
+bool TelemetryServer::waitForClient(int msecs)
+{
+    if (clients.isEmpty() && !server->hasPendingConnections())
+    {
+        server->waitForNewConnection(msecs);
+    }
+    acceptClients();
+    return !clients.isEmpty();
+}
+
+// Takes every waiting connection
+void TelemetryServer::acceptClients()
+{
+    while (server->hasPendingConnections())
+    {
+        Client client;
+        client.socket = server->nextPendingConnection();
+        connect(client.socket, &QLocalSocket::disconnected, this, &TelemetryServer::removeClient);
+        clients.append(client);
+    }
+}
+
+// Forgets a client that disconnected
+// A write in publish() can disconnect a client right away, then it is only
+// marked so the loop doesn't skip the next client
+void TelemetryServer::removeClient()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    for (int i = 0; i < clients.size(); ++i)
+    {
+        if (clients[i].socket == socket)
+        {
+            if (publishing)
+            {
+                clients[i].disconnected = true;
+            }
+            else
+            {
+                clients.removeAt(i);
+            }
+            break;
+        }
+    }
+    if (socket)
+    {
+        socket->deleteLater();
+    }
+}
+
+// Sends this tick to every client that has room for it
+void TelemetryServer::publish(const GameSimulation& simulation)
+{
+    tick++;
+    if (clients.isEmpty())
+    {
+        return;
+    }
+
+    // Worked out once for all clients
+    quint32 fieldChecksum = checksum(simulation.getGrid());
+
+    // Clients that disconnect during the loop are removed after it
+    publishing = true;
+    for (Client& client : clients)
+    {
+        if (client.disconnected)
+        {
+            continue;
+        }
+
+        // The socket still holds earlier messages, so this tick waits
+        // Tiles keep their versions, the next delta includes everything missed
+        if (client.socket->bytesToWrite() > maxPendingBytes)
+        {
+            updatesSkipped++;
+            continue;
+        }
+        send(client, simulation, fieldChecksum);
+    }
+    publishing = false;
+
+    for (int i = clients.size() - 1; i >= 0; --i)
+    {
+        if (clients[i].disconnected)
+        {
+            clients.removeAt(i);
+        }
+    }
+}
+
+// Sends the last state to everyone and closes the connections
+void TelemetryServer::finish(const GameSimulation& simulation, int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    acceptClients();
+    quint32 fieldChecksum = checksum(simulation.getGrid());
+
+    // Clients are removed below, not when their socket reports the disconnect
+    for (Client& client : clients)
+    {
+        client.socket->disconnect(this);
+    }
+
+    for (Client& client : clients)
+    {
+        if (client.socket->state() != QLocalSocket::ConnectedState)
+        {
+            continue;
+        }
+
+        // Let a slow client read what is queued before the final delta
+        while (client.socket->state() == QLocalSocket::ConnectedState
+               && client.socket->bytesToWrite() > maxPendingBytes && timer.elapsed() < msecs)
+        {
+            client.socket->waitForBytesWritten(qMax(1, msecs - static_cast<int>(timer.elapsed())));
+        }
+        send(client, simulation, fieldChecksum);
+    }
+
+    // disconnectFromServer() waits for the remaining data to be written
+    for (Client& client : clients)
+    {
+        while (client.socket->state() == QLocalSocket::ConnectedState
+               && client.socket->bytesToWrite() > 0 && timer.elapsed() < msecs)
+        {
+            client.socket->waitForBytesWritten(qMax(1, msecs - static_cast<int>(timer.elapsed())));
+        }
+        client.socket->disconnectFromServer();
+        client.socket->deleteLater();
+    }
+    clients.clear();
+}
+
+// Weighted sum of all cells, so a cell with a wrong value or in the wrong place is noticed
+quint32 TelemetryServer::checksum(const PastureGrid& grid)
+{
+    quint32 sum = 0;
+    quint32 index = 1;
+    for (int x = 0; x < grid.width(); ++x)
+    {
+        const quint8* column = grid.column(x);
+        for (int y = 0; y < grid.height(); ++y)
+        {
+            sum += column[y] * index++;
+        }
+    }
+    return sum;
+}
+
+// Picks a snapshot for new clients and resized fields, otherwise a delta
+void TelemetryServer::send(Client& client, const GameSimulation& simulation, quint32 fieldChecksum)
+{
+    if (client.needsSnapshot || client.sentGeneration != simulation.getGrid().getGeneration())
+    {
+        writeSnapshot(client, simulation, fieldChecksum);
+    }
+    else
+    {
+        writeDelta(client, simulation, fieldChecksum);
+    }
+    finishMessage(client);
+}
+
+// Whole field, with the upgrade names the deltas refer to by position
+void TelemetryServer::writeSnapshot(Client& client, const GameSimulation& simulation, quint32 fieldChecksum)
+{
+    const PastureGrid& grid = simulation.getGrid();
+
+    message.resize(0);
+    appendValue<quint32>(message, 0);  // Length, filled in by finishMessage
+    appendValue<quint8>(message, Snapshot);
+    appendValue<quint16>(message, grid.width());
+    appendValue<quint16>(message, grid.height());
+
+    const QVector<GameSimulation::Upgrade*>& upgrades = simulation.getUpgrades();
+    appendValue<quint8>(message, upgrades.size());
+    for (const GameSimulation::Upgrade* upgrade : upgrades)
+    {
+        QByteArray name = upgrade->name.toUtf8();
+        appendValue<quint8>(message, name.size());
+        message.append(name);
+    }
+
+    writeState(simulation, fieldChecksum);
+    writeCells(grid, 0, 0, grid.width(), grid.height());
+
+    // Everything up to now has been sent
+    client.needsSnapshot = false;
+    client.sentGeneration = grid.getGeneration();
+    client.sentTileVersions.resize(grid.getTileColumns() * grid.getTileRows());
+    for (int tileX = 0; tileX < grid.getTileColumns(); ++tileX)
+    {
+        for (int tileY = 0; tileY < grid.getTileRows(); ++tileY)
+        {
+            client.sentTileVersions[tileX * grid.getTileRows() + tileY] = grid.tileVersion(tileX, tileY);
+        }
+    }
+}
+
+// Only the tiles whose version moved since this client last heard about them
+void TelemetryServer::writeDelta(Client& client, const GameSimulation& simulation, quint32 fieldChecksum)
+{
+    const PastureGrid& grid = simulation.getGrid();
+
+    message.resize(0);
+    appendValue<quint32>(message, 0);  // Length, filled in by finishMessage
+    appendValue<quint8>(message, Delta);
+    writeState(simulation, fieldChecksum);
+
+    // Tile count is filled in after the tiles
+    int countOffset = message.size();
+    appendValue<quint16>(message, 0);
+    quint16 tileCount = 0;
+
+    for (int tileX = 0; tileX < grid.getTileColumns(); ++tileX)
+    {
+        for (int tileY = 0; tileY < grid.getTileRows(); ++tileY)
+        {
+            quint32 version = grid.tileVersion(tileX, tileY);
+            quint32& sent = client.sentTileVersions[tileX * grid.getTileRows() + tileY];
+            if (version == sent)
+            {
+                continue;
+            }
+            sent = version;
+            tileCount++;
+
+            int left = tileX * PastureGrid::tileSize;
+            int top = tileY * PastureGrid::tileSize;
+            appendValue<quint16>(message, tileX);
+            appendValue<quint16>(message, tileY);
+            writeCells(grid, left, top,
+                       qMin(left + PastureGrid::tileSize, grid.width()),
+                       qMin(top + PastureGrid::tileSize, grid.height()));
+        }
+    }
+
+    quint16 littleEndianCount = qToLittleEndian(tileCount);
+    memcpy(message.data() + countOffset, &littleEndianCount, sizeof(littleEndianCount));
+}
+
+// Herd, money and upgrades, sent with every message
+void TelemetryServer::writeState(const GameSimulation& simulation, quint32 fieldChecksum)
+{
+    appendValue<quint32>(message, tick);
+    appendValue<qint16>(message, simulation.getHerdX());
+    appendValue<qint16>(message, simulation.getHerdY());
+    appendValue<qint16>(message, simulation.getHerdWidth());
+    appendValue<qint16>(message, simulation.getHerdHeight());
+    appendDouble(message, simulation.getMoney());
+    appendValue<qint32>(message, simulation.getSuperDays());
+    for (const GameSimulation::Upgrade* upgrade : simulation.getUpgrades())
+    {
+        appendValue<quint16>(message, upgrade->level);
+    }
+    appendValue<quint32>(message, fieldChecksum);
+}
+
+// Packs a rectangle of cells column by column, two 4 bit levels per byte
+void TelemetryServer::writeCells(const PastureGrid& grid, int left, int top, int right, int bottom)
+{
+    quint8 pending = 0;
+    bool hasPending = false;
+    for (int x = left; x < right; ++x)
+    {
+        const quint8* column = grid.column(x);
+        for (int y = top; y < bottom; ++y)
+        {
+            if (hasPending)
+            {
+                message.append(static_cast<char>(pending | (column[y] << 4)));
+            }
+            else
+            {
+                pending = column[y];
+            }
+            hasPending = !hasPending;
+        }
+    }
+    // An odd cell count leaves the high nibble empty
+    if (hasPending)
+    {
+        message.append(static_cast<char>(pending));
+    }
+}
+
+// Fills in the message length and hands the message to the socket
+// The socket buffers it, so this returns without waiting for the client
+void TelemetryServer::finishMessage(Client& client)
+{
+    quint32 length = qToLittleEndian(static_cast<quint32>(message.size() - sizeof(quint32)));
+    memcpy(message.data(), &length, sizeof(length));
+
+    client.socket->write(message);
+    messagesSent++;
+    bytesSent += message.size();
+}
@@ -0,0 +1,114 @@
+#ifndef TELEMETRY_SERVER_H
+#define TELEMETRY_SERVER_H
+
+#include <QObject>          // Base class for signals and slots
+#include <QVector>          // Dynamic array container
+#include <QByteArray>       // Message bytes
+#include <QString>          // Server name
+
+class QLocalServer;
+class QLocalSocket;
+class GameSimulation;
+class PastureGrid;
+
+// Telemetry server streaming the game state over a local socket
+// (a Unix domain socket, or a named pipe on Windows)
+//
+// Every client first gets a snapshot of the whole field, then one delta per
+// tick holding only the tiles of the grid that changed. A client that has not
+// read its data yet is skipped, and the changes it missed are sent together
+// once it catches up, so a slow client never holds up the game.
+//
+// Protocol, all numbers little endian:
+//   message:  quint32 length of the rest, quint8 type, payload
+//   snapshot (type 1):
+//     quint16 grid width, quint16 grid height
+//     quint8 upgrade count, then per upgrade quint8 name length and UTF-8 name
+//     state
+//     every cell, column by column, two cells per byte (low nibble first)
+//   delta (type 2):
+//     state
+//     quint16 tile count, then per tile quint16 tile x, quint16 tile y and the
+//     cells of the tile inside the field, column by column, two cells per byte
+//   state:
+//     quint32 tick, qint16 herd x, y, width, height, double money,
+//     qint32 super days, quint16 level per upgrade in snapshot order,
+//     quint32 checksum of the whole field after the message is applied
+class TelemetryServer : public QObject
+{
+    // Qt macro to include signals and slots
+    Q_OBJECT
+
+public:
+    // Message types
+    enum MessageType {
+        Snapshot = 1,   // Whole field
+        Delta = 2       // Changed tiles only
+    };
+
+    // constructor to create a server that is not listening yet
+    explicit TelemetryServer(QObject* parent = nullptr);
+
+    // deconstructor that disconnects all clients
+    ~TelemetryServer();
+
+    // Starts listening on a local socket name, replacing a stale socket left by a crash
+    bool listen(const QString& name, QString* errorMessage);
+
+    // Waits up to msecs for the first client, for runs without an event loop
+    bool waitForClient(int msecs);
+
+    // Sends the current state to every client that is keeping up
+    // Never blocks, clients with too much unread data are skipped this tick
+    void publish(const GameSimulation& simulation);
+
+    // Sends the final state to every client, waiting up to msecs for slow ones, and disconnects
+    void finish(const GameSimulation& simulation, int msecs);
+
+    // Checksum of every cell, clients compare it against their copy of the field
+    static quint32 checksum(const PastureGrid& grid);
+
+    // methods to get server statistics
+    int getClientCount() const { return clients.size(); }
+    quint64 getMessagesSent() const { return messagesSent; }
+    quint64 getBytesSent() const { return bytesSent; }
+    quint64 getUpdatesSkipped() const { return updatesSkipped; }
+
+private slots:
+    void acceptClients();       // Takes new connections from the server
+    void removeClient();        // Called when a client disconnects
+
+private:
+    // client structure remembering what a client has been sent
+    struct Client {
+        QLocalSocket* socket = nullptr;     // Connection to the client
+        bool disconnected = false;          // Gone while publishing, removed after the loop
+        bool needsSnapshot = true;          // true until the client got the whole field
+        quint32 sentGeneration = 0;         // Grid generation of the last snapshot
+        QVector<quint32> sentTileVersions;  // Tile versions the client has seen
+    };
+
+    // Unread bytes a client may have before it is skipped
+    static const qint64 maxPendingBytes = 256 * 1024;
+
+    QLocalServer* server;      // Accepts connections
+    QVector<Client> clients;   // Connected clients
+    QByteArray message;        // Reused message buffer
+    quint32 tick;              // Number of published ticks
+    bool publishing;           // true while publish() loops over the clients
+
+    // Statistics
+    quint64 messagesSent;      // Messages written to clients
+    quint64 bytesSent;         // Bytes written to clients
+    quint64 updatesSkipped;    // Ticks a slow client missed, sent later as one delta
+
+    // Message functions
+    void send(Client& client, const GameSimulation& simulation, quint32 fieldChecksum);      // Snapshot or delta
+    void writeSnapshot(Client& client, const GameSimulation& simulation, quint32 fieldChecksum);
+    void writeDelta(Client& client, const GameSimulation& simulation, quint32 fieldChecksum);
+    void writeState(const GameSimulation& simulation, quint32 fieldChecksum);  // Shared state block
+    void writeCells(const PastureGrid& grid, int left, int top, int right, int bottom);  // Packs cells two per byte
+    void finishMessage(Client& client);                                // Fills in the length and writes
+};
+
+#endif // TELEMETRY_SERVER_H
@@ -0,0 +1,279 @@
+#include "time_lapse_exporter.h"
+#include "game_simulation.h"
+#include <cstring>         // For memset and memcpy
+
+
+// Exporter constructor
+TimeLapseExporter::TimeLapseExporter(Format format, int framesPerSecond, int bufferCount, Overflow overflow)
+    : format(format), framesPerSecond(framesPerSecond), overflow(overflow), headerWritten(false),
+    stopping(false), framesWritten(0), framesDropped(0)
+{
+    initializePalette();
+
+    // Allocate every frame up front so exporting never allocates per frame
+    frames.resize(qMax(1, bufferCount));
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        frames[i].resize(frameWidth * frameHeight);
+        freeFrames.append(i);
+    }
+    readyFrames.reserve(frames.size());
+
+    // Y4M and PPM both use 3 bytes per pixel
+    encoded.resize(frameWidth * frameHeight * 3);
+    frameHeader = format == Format::Y4M
+        ? QByteArray("FRAME\n")
+        : QByteArray("P6\n") + QByteArray::number(frameWidth) + ' '
+              + QByteArray::number(frameHeight) + "\n255\n";
+}
+
+// Destructor makes sure the encoder thread is stopped
+TimeLapseExporter::~TimeLapseExporter()
+{
+    finish();
+}
+
+// Builds the colors for each palette index
+// Matches the colors used by GameDisplayWidget
+void TimeLapseExporter::initializePalette()
+{
+    for (int i = 0; i < PaletteSize; ++i)
+    {
+        int red = 0, green = 0, blue = 0;
+        if (i <= GameSimulation::maxGrowth)
+        {
+            // Higher growth = darker green
+            double ratio = static_cast<double>(i) / GameSimulation::maxGrowth;
+            green = 100 + static_cast<int>(155 * ratio);
+        }
+        else if (i == GridLine)
+        {
+            green = 80;
+        }
+        else if (i == Herd)
+        {
+            red = 101; green = 67; blue = 33;
+        }
+        else  // Herd border
+        {
+            red = 255; green = 255; blue = 255;
+        }
+
+        paletteRgb[i][0] = static_cast<quint8>(red);
+        paletteRgb[i][1] = static_cast<quint8>(green);
+        paletteRgb[i][2] = static_cast<quint8>(blue);
+
+        // BT.601 studio range conversion used by most Y4M tools
+        double y = 16 + (65.481 * red + 128.553 * green + 24.966 * blue) / 255.0;
+        double u = 128 + (-37.797 * red - 74.203 * green + 112.0 * blue) / 255.0;
+        double v = 128 + (112.0 * red - 93.786 * green - 18.214 * blue) / 255.0;
+        paletteYuv[i][0] = static_cast<quint8>(qBound(0, qRound(y), 255));
+        paletteYuv[i][1] = static_cast<quint8>(qBound(0, qRound(u), 255));
+        paletteYuv[i][2] = static_cast<quint8>(qBound(0, qRound(v), 255));
+    }
+}
+
+// Opens the output and starts the encoder thread
+bool TimeLapseExporter::open(const QString& path)
+{
+    bool opened = path == "-" ? output.open(stdout, QIODevice::WriteOnly)
+                              : (output.setFileName(path), output.open(QIODevice::WriteOnly));
+    if (!opened)
+    {
+        return false;
+    }
+
+    encoder = std::thread(&TimeLapseExporter::encoderLoop, this);
+    return true;
+}
+
+// Renders a frame for the encoder thread
+bool TimeLapseExporter::submitFrame(const GameSimulation& simulation)
+{
+    // Take a free buffer, waiting for the encoder to give one back if allowed
+    int index;
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        if (overflow == Overflow::Wait)
+        {
+            frameFreed.wait(lock, [this]() { return !freeFrames.isEmpty(); });
+        }
+        else if (freeFrames.isEmpty())
+        {
+            framesDropped++;
+            return false;
+        }
+        index = freeFrames.takeLast();
+    }
+
+    // Render outside the lock, the buffer belongs to the simulation until queued
+    renderFrame(simulation, frames[index]);
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        readyFrames.append(index);
+    }
+    queueWait.notify_one();
+    return true;
+}
+
+// Draws the field straight from the grid as palette indices
+void TimeLapseExporter::renderFrame(const GameSimulation& simulation, QVector<quint8>& frame)
+{
+    const PastureGrid& grid = simulation.getGrid();
+    int fieldSizePx = GameSimulation::fieldSizes[simulation.getFieldSize()];
+    int gridWidth = qMin(grid.width(), frameWidth / fieldSizePx);
+    int gridHeight = qMin(grid.height(), frameHeight / fieldSizePx);
+    bool drawGridLines = fieldSizePx >= 4;  // Finer fields would be all grid lines
+    quint8* pixels = frame.data();
+
+    // Anything the grid doesn't cover stays empty field
+    memset(pixels, 0, frame.size());
+
+    // Draw grass one cell row at a time
+    for (int cellY = 0; cellY < gridHeight; ++cellY)
+    {
+        quint8* row = pixels + cellY * fieldSizePx * frameWidth;
+
+        // First pixel row of the cells
+        for (int cellX = 0; cellX < gridWidth; ++cellX)
+        {
+            memset(row + cellX * fieldSizePx, grid.at(cellX, cellY), fieldSizePx);
+            if (drawGridLines)
+            {
+                row[cellX * fieldSizePx] = GridLine;  // Left grid line
+            }
+        }
+
+        // Copy it for the rest of the cell height
+        for (int i = 1; i < fieldSizePx; ++i)
+        {
+            memcpy(row + i * frameWidth, row, gridWidth * fieldSizePx);
+        }
+
+        // Top grid line
+        if (drawGridLines)
+        {
+            memset(row, GridLine, gridWidth * fieldSizePx);
+        }
+    }
+
+    // Draw herd as a brown rectangle
+    int left = simulation.getHerdX() * fieldSizePx;
+    int top = simulation.getHerdY() * fieldSizePx;
+    int right = left + simulation.getHerdWidth() * fieldSizePx;     // Border column, one past the herd
+    int bottom = top + simulation.getHerdHeight() * fieldSizePx;    // Border row, one past the herd
+    int fillRight = qMin(right, frameWidth);
+    for (int y = top; y < qMin(bottom, frameHeight); ++y)
+    {
+        memset(pixels + y * frameWidth + left, Herd, fillRight - left);
+    }
+
+    // Draw white border around the herd, clipped to the frame
+    int borderRight = qMin(right + 1, frameWidth);
+    memset(pixels + top * frameWidth + left, HerdBorder, borderRight - left);
+    if (bottom < frameHeight)
+    {
+        memset(pixels + bottom * frameWidth + left, HerdBorder, borderRight - left);
+    }
+    for (int y = top; y < qMin(bottom, frameHeight); ++y)
+    {
+        pixels[y * frameWidth + left] = HerdBorder;
+        if (right < frameWidth)
+        {
+            pixels[y * frameWidth + right] = HerdBorder;
+        }
+    }
+}
+
+// Encoder thread waits for frames and writes them in order
+void TimeLapseExporter::encoderLoop()
+{
+    for (;;)
+    {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueWait.wait(lock, [this]() { return stopping || !readyFrames.isEmpty(); });
+            if (readyFrames.isEmpty())
+            {
+                return;  // Stopping and nothing left to write
+            }
+            index = readyFrames.takeFirst();
+        }
+
+        writeFrame(frames.at(index));
+
+        // Give the buffer back to the simulation
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            freeFrames.append(index);
+        }
+        frameFreed.notify_one();
+    }
+}
+
+// Converts palette indices to the output format and writes the frame
+void TimeLapseExporter::writeFrame(const QVector<quint8>& frame)
+{
+    // Y4M streams have one header before the first frame
+    if (!headerWritten && format == Format::Y4M)
+    {
+        output.write(QByteArray("YUV4MPEG2 W") + QByteArray::number(frameWidth)
+                     + " H" + QByteArray::number(frameHeight)
+                     + " F" + QByteArray::number(framesPerSecond) + ":1 Ip A1:1 C444\n");
+    }
+    headerWritten = true;
+
+    const quint8* pixels = frame.constData();
+    quint8* out = reinterpret_cast<quint8*>(encoded.data());
+    int pixelCount = frameWidth * frameHeight;
+
+    if (format == Format::Y4M)
+    {
+        // Y, U and V planes one after another
+        output.write(frameHeader);
+        for (int i = 0; i < pixelCount; ++i)
+        {
+            const quint8* yuv = paletteYuv[pixels[i]];
+            out[i] = yuv[0];
+            out[pixelCount + i] = yuv[1];
+            out[2 * pixelCount + i] = yuv[2];
+        }
+    }
+    else
+    {
+        // Every PPM frame is a complete image with its own header
+        output.write(frameHeader);
+        for (int i = 0; i < pixelCount; ++i)
+        {
+            const quint8* rgb = paletteRgb[pixels[i]];
+            out[3 * i] = rgb[0];
+            out[3 * i + 1] = rgb[1];
+            out[3 * i + 2] = rgb[2];
+        }
+    }
+
+    output.write(encoded.constData(), encoded.size());
+    framesWritten++;
+}
+
+// Stops the encoder once every queued frame is written
+void TimeLapseExporter::finish()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueWait.notify_one();
+
+    if (encoder.joinable())
+    {
+        encoder.join();
+    }
+    if (output.isOpen())
+    {
+        output.flush();
+        output.close();
+    }
+}
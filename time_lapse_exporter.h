@@ -0,0 +1,104 @@
+#ifndef TIME_LAPSE_EXPORTER_H
+#define TIME_LAPSE_EXPORTER_H
+
+#include <QFile>              // Output file or stdout
+#include <QVector>            // Dynamic array container
+#include <QByteArray>         // Encoded frame bytes
+#include <atomic>             // Frame counters shared with the encoder
+#include <condition_variable> // Wakes the encoder thread
+#include <mutex>              // Guards the frame queues
+#include <thread>             // Background encoder thread
+
+class GameSimulation;
+
+// Time-lapse exporter that streams the field as raw video frames
+// The simulation renders into preallocated frame buffers and a background
+// thread converts and writes them, so the simulation never waits on I/O
+class TimeLapseExporter
+{
+public:
+    // Raw video formats that can be written
+    enum class Format {
+        Y4M,  // YUV4MPEG2 stream, 4:4:4 planes
+        PPM   // Concatenated binary PPM (P6) images
+    };
+
+    // What submitFrame() does when every buffer is waiting for the encoder
+    enum class Overflow {
+        Wait,  // Wait for the encoder, nothing is lost (runs without a realtime clock)
+        Drop   // Skip the frame so the caller never waits
+    };
+
+    // Constructor that preallocates bufferCount frames
+    explicit TimeLapseExporter(Format format, int framesPerSecond = 30, int bufferCount = 8,
+                               Overflow overflow = Overflow::Wait);
+
+    // deconstructor that flushes and stops the encoder thread
+    ~TimeLapseExporter();
+
+    // Opens the output, "-" writes to stdout
+    bool open(const QString& path);
+
+    // Renders the current field into a free buffer and queues it
+    // Returns false if the frame was dropped because the encoder is behind,
+    // which only happens with Overflow::Drop
+    bool submitFrame(const GameSimulation& simulation);
+
+    // Writes all queued frames and closes the output
+    void finish();
+
+    // methods to get export statistics
+    int getFramesWritten() const { return framesWritten; }
+    int getFramesDropped() const { return framesDropped; }
+
+private:
+    // Palette indices used in rendered frames
+    // 0-15 are grass growth levels
+    enum PaletteIndex {
+        GridLine = 16,    // Dark green grid lines
+        Herd = 17,        // Brown herd
+        HerdBorder = 18,  // White herd border
+        PaletteSize = 19
+    };
+
+    // Frame size matches the game display
+    static constexpr int frameWidth = 500;
+    static constexpr int frameHeight = 500;
+
+    // Output settings
+    Format format;         // Output format
+    int framesPerSecond;   // Frame rate written to the Y4M header
+    Overflow overflow;     // Wait for or drop frames when the encoder is behind
+    QFile output;          // File or stdout
+    bool headerWritten;    // Stream header is written before the first frame
+
+    // Colors for each palette index
+    quint8 paletteRgb[PaletteSize][3];  // Red, green, blue
+    quint8 paletteYuv[PaletteSize][3];  // Y, U, V
+
+    // Frame buffers hold one palette index per pixel
+    QVector<QVector<quint8>> frames;  // Preallocated frames
+    QVector<int> freeFrames;          // Frames the simulation can render into
+    QVector<int> readyFrames;         // Frames waiting for the encoder, oldest first
+    QByteArray encoded;               // Preallocated encoder output
+    QByteArray frameHeader;           // Written before every frame
+
+    // Encoder thread state
+    std::thread encoder;               // Background encoder thread
+    std::mutex queueMutex;             // Guards freeFrames, readyFrames and stopping
+    std::condition_variable queueWait; // Signals new frames or shutdown
+    std::condition_variable frameFreed; // Signals a buffer given back by the encoder
+    bool stopping;                     // Tells the encoder to finish
+
+    // Statistics
+    std::atomic<int> framesWritten;  // Frames written to the output
+    std::atomic<int> framesDropped;  // Frames skipped because no buffer was free
+
+    // Helper functions
+    void initializePalette();                                              // Builds RGB and YUV colors
+    void renderFrame(const GameSimulation& simulation, QVector<quint8>& frame);  // Draws the field as palette indices
+    void encoderLoop();                                                    // Runs on the encoder thread
+    void writeFrame(const QVector<quint8>& frame);                         // Converts and writes one frame
+};
+
+#endif // TIME_LAPSE_EXPORTER_H
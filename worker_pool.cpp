@@ -0,0 +1,90 @@
+#include "worker_pool.h"
+
+
+// Pool constructor
+WorkerPool::WorkerPool(int threadCount)
+{
+    for (int i = 1; i < threadCount; ++i)
+    {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+// Destructor waits for the workers to exit
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// Runs all jobs and waits for them
+void WorkerPool::run(int jobCount, const std::function<void(int)>& job)
+{
+    // Not worth waking anyone for a single job
+    if (workers.empty() || jobCount <= 1)
+    {
+        for (int i = 0; i < jobCount; ++i)
+        {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job = &job;
+        this->jobCount = jobCount;
+        nextJob = 0;
+        busyWorkers = static_cast<int>(workers.size());
+        runNumber++;
+    }
+    wakeWorkers.notify_all();
+
+    // Help out, then wait for the workers still busy
+    takeJobs();
+    std::unique_lock<std::mutex> lock(mutex);
+    jobsDone.wait(lock, [this]() { return busyWorkers == 0; });
+    this->job = nullptr;
+}
+
+// Waits for runs and works on them
+void WorkerPool::workerLoop()
+{
+    quint64 seenRun = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [&]() { return stopping || runNumber != seenRun; });
+            if (stopping)
+            {
+                return;
+            }
+            seenRun = runNumber;
+        }
+
+        takeJobs();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        jobsDone.notify_one();
+    }
+}
+
+// Takes job numbers until all are taken
+void WorkerPool::takeJobs()
+{
+    for (int i = nextJob++; i < jobCount; i = nextJob++)
+    {
+        (*job)(i);
+    }
+}
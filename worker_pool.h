@@ -0,0 +1,50 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <QtGlobal>           // Qt types and macros
+#include <atomic>             // Next job counter shared by the threads
+#include <condition_variable> // Wakes the workers
+#include <functional>         // For std::function
+#include <mutex>              // Guards the job state
+#include <thread>             // Worker threads
+#include <vector>             // Worker list
+
+// Worker pool class running numbered jobs on a fixed set of threads
+// The calling thread works on the jobs too, and run() returns once every job
+// is done. Threads are started once, so running jobs never creates threads
+class WorkerPool
+{
+public:
+    // constructor that starts threadCount - 1 workers, the caller is the last thread
+    explicit WorkerPool(int threadCount);
+
+    // deconstructor that stops the workers
+    ~WorkerPool();
+
+    // Runs job(0) to job(jobCount - 1) in any order and waits for all of them
+    // job is used by several threads at once, so it must only change data of its own job
+    void run(int jobCount, const std::function<void(int)>& job);
+
+    // Threads working on jobs, including the caller
+    int getThreadCount() const { return static_cast<int>(workers.size()) + 1; }
+
+private:
+    Q_DISABLE_COPY(WorkerPool)
+
+    std::vector<std::thread> workers;     // Worker threads
+    std::mutex mutex;                     // Guards everything below except nextJob
+    std::condition_variable wakeWorkers;  // Signals new jobs or shutdown
+    std::condition_variable jobsDone;     // Signals the last worker finished
+
+    const std::function<void(int)>* job = nullptr;  // Job of the current run
+    int jobCount = 0;                     // Jobs in the current run
+    std::atomic<int> nextJob{0};          // Next job number to take
+    int busyWorkers = 0;                  // Workers still in the current run
+    quint64 runNumber = 0;                // Changes for every run, so workers see new work
+    bool stopping = false;                // Tells the workers to exit
+
+    void workerLoop();   // Runs on each worker thread
+    void takeJobs();     // Takes and runs jobs until none are left
+};
+
+#endif // WORKER_POOL_H